@@ -0,0 +1,84 @@
+#ifndef APP_SAMPLE_SONG_H
+#define APP_SAMPLE_SONG_H
+
+// generated by ATTiny13SongPack from sample.song, do not edit
+// 6 patterns played, 5 kept, 9 entries, 176 beats per pass
+// 67 bytes of flash, 81 written out as one melody
+
+// m-toolbox/MelodyStream.h has to be included before
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+namespace SampleSong {
+    // 1/100 Hz, note indices the song plays, each waveform engine derives its timer settings from these
+    constexpr uint32_t NOTES_FREQUENCIES[] = {
+            117466,     // D6, repeat
+            104650,     // C6, drum
+            117466,     // D6
+            131851,     // E6
+            139691,     // F6
+            156798,     // G6
+            176000,     // A6
+            197553,     // B6
+            209300,     // C7
+            234932,     // D7
+            263702,     // E7
+            279383,     // F7
+            313596,     // G7
+            352000,     // A7
+            395107,     // B7
+            104650,     // C6, repeat
+    };
+
+    const uint8_t CODES[] PROGMEM = {
+            0xAA, 0x0A, 0x08, 0xA0, 0xC0, 0xF1, 0x50, 0xF1, 0x80, 0x05, 0x00, 0x30,
+            0x06, 0x07, 0x06, 0x60, 0x5A, 0xCD, 0x0B, 0xC0, 0xA0, 0x89, 0x70, 0xF1,
+            0x10, 0xF1, 0x10, 0xF1, 0x10, 0x10, 0x10, 0x10, 0x0F, 0x60,
+    };
+
+    const uint8_t PATTERN_STARTS[] PROGMEM = {
+            0,       // intro
+            16,      // theme
+            32,      // run
+            48,      // fill
+            64,      // rest
+            67,
+    };
+
+    const SongEntry ENTRIES[] PROGMEM = {
+            { 0, 1, 0 },        // intro
+            { 1, 2, 0 },        // theme
+            { 2, 1, 0 },        // run
+            { 1, 1, 2 },        // theme
+            { 2, 1, 1 },        // run
+            { 3, 1, 0 },        // fill
+            { 0, 1, 0 },        // intro
+            { 1, 2, 0 },        // theme
+            { 4, 2, 0 },        // rest
+    };
+
+    struct Song {
+        typedef uint8_t Position;
+
+        static const uint8_t ENTRIES_COUNT = 9;
+
+        // note indices up to this one are drums, FlashMemoryMelody plays them as noise, 0 for none
+        static const uint8_t LAST_NOISE_NOTE = 1;
+
+        static const uint8_t* codes() {
+            return CODES;
+        }
+
+        static const Position* patternStarts() {
+            return PATTERN_STARTS;
+        }
+
+        static const SongEntry* entries() {
+            return ENTRIES;
+        }
+    };
+}
+
+#endif // APP_SAMPLE_SONG_H
@@ -2,70 +2,135 @@
 #include "../m-toolbox/AvrGccBuiltins.h"
 
 #include "../m-toolbox/Macro.h"
+#include "../m-toolbox/ConstDiv.h"
+#include "../m-toolbox/Glide.h"
+#include "../m-toolbox/MelodyStream.h"
 #include "../m-toolbox/ComboPin.h"
 #include "../m-toolbox/OutputPin.h"
+#include "../m-toolbox/PinGroup.h"
+#include "../m-toolbox/VerticalDebouncer.h"
 
 #include <util/delay.h>
 #include <avr/pgmspace.h>
+#include <avr/wdt.h>
+
+#ifdef STACK_PAINT
+#include "../m-toolbox/StackPaint.h"
+
+#include <avr/eeprom.h>
+#endif
+
+// -------- CONFIG --------
+
+// waveform generator engine, pick with -DWAVEFORM_ENGINE=...
+// CTC: 1-bit WAVEFORMS patterns bit-banged on PB0 from compb interrupt
+// DDS: phase accumulator over PROGMEM wavetables, fast pwm on OC0A (PB0) from overflow interrupt
+// SQUARE: square waves only, toggled on OC0A (PB0) by Timer0 hardware, beats counted in system ticks
+// DUO: two pulse voices toggling PB0 from compa and compb interrupts, beats counted in system ticks
+#define WAVEFORM_ENGINE_CTC 1
+#define WAVEFORM_ENGINE_DDS 2
+#define WAVEFORM_ENGINE_SQUARE 3
+#define WAVEFORM_ENGINE_DUO 4
+
+#ifndef WAVEFORM_ENGINE
+#define WAVEFORM_ENGINE WAVEFORM_ENGINE_CTC
+#endif
+
+// steps of CTC waveforms, pick with -DWAVE_STEPS=8, 16 or 32:
+// more steps give finer waveforms, but shorter segments the segment interrupt has to keep up with
+#ifndef WAVE_STEPS
+#define WAVE_STEPS 8
+#endif
+
+// optional features, each costs flash the 1 KB default images do not have room for:
+// -DGLIDE: CTC and DDS play bends (sweeps and slides, see m-toolbox/Glide.h), without it notes play at their pitch
+// -DNOISE: last waveform is noise and FlashMemoryMelody plays the drums of the song with it,
+// without it drums are rests
+// -DREST_POWER_DOWN: CTC and DDS stop Timer0 and power down through rests longer than a system tick,
+// without it rests play silent periods or samples
+
+// one of the Logic classes in NOTES SEQUENCES, pick with -DMAIN_LOGIC=...
+#ifndef MAIN_LOGIC
+#define MAIN_LOGIC Fooz::Logic
+#endif
+
+// song FlashMemoryMelody plays, with the notes table every logic plays from, see tools/host/song;
+// -DSONG=tune.mid packs a midi file at build time into a header passed as -DSONG_HEADER=...
+// (SampleSong.h is packed from res/songs/sample.song with `make song_pack`)
+#ifndef SONG_HEADER
+#define SONG_HEADER "SampleSong.h"
+#endif
+
+#include SONG_HEADER
+
+// debug build, -DSTACK_PAINT: stack high-water mark is kept in StackPaint::highWater
+// and in eeprom at STACK_HIGH_WATER_EEPROM_ADDRESS, read it back with `make stack_read`
+#define STACK_HIGH_WATER_EEPROM_ADDRESS 0
 
-// -------- UTILS --------
+// ----------------
 
-namespace divv {
-    uint8_t remainder;
+// -------- NOTES DATA --------
 
-    uint8_t div(uint8_t dividend, const uint8_t divisor) {
-        uint8_t result = 0;
-        while (dividend >= divisor) {
-            dividend -= divisor;
-            result++;
-        }
-        remainder = dividend;
-        return result;
-    }
+// 1/100 Hz, each waveform engine derives its own timer settings from these at compile time
+using SampleSong::NOTES_FREQUENCIES;
+
+const uint8_t NOTES_COUNT = sizeof(NOTES_FREQUENCIES) / sizeof(NOTES_FREQUENCIES[0]);
+
+// cpu cycles in one period of a note
+constexpr uint32_t noteCycles(const uint8_t noteIndex) {
+    return static_cast<uint32_t>(
+            (F_CPU * 100ull + NOTES_FREQUENCIES[noteIndex] / 2u) / NOTES_FREQUENCIES[noteIndex]);
+}
+
+// 1 ppm is ~0.0017 cents
+constexpr uint32_t pitchErrorPpm(const uint32_t targetCycles, const uint32_t actualCycles) {
+    const uint32_t difference = targetCycles > actualCycles ? targetCycles - actualCycles : actualCycles - targetCycles;
+    return static_cast<uint32_t>(difference * 1000000ull / targetCycles);
 }
 
 // ----------------
 
-// -------- NOTES DATA --------
+// -------- TIMER0 CLOCK DATA --------
+
+struct Timer0Clock {
+    uint16_t prescaler;
 
-const uint8_t NOTES_DIVISIONS[] PROGMEM = {
-        255,
-
-        200, 		//C6    //0x1
-        193, 		//D6    //0x2
-        185, 		//E6    //0x3
-        181, 		//F6    //0x4
-        171, 		//G6    //0x5
-        209, 		//A6    //0x6
-        203, 		//B6    //0x7
-
-        143, 		//C7    //0x8
-        129, 		//D7    //0x9
-        113, 		//E7    //0xA
-        104, 		//F7    //0xB
-        86, 		//G7    //0xC
-        161, 		//A7    //0xD
-        149, 		//B7    //0xE
-
-        255
+    // TCCR0B clock select bits
+    uint8_t clockSelect;
 };
 
-const uint8_t NOTES_COUNT = sizeof(NOTES_DIVISIONS) / sizeof(uint8_t);
+constexpr Timer0Clock TIMER0_CLOCKS[] = {
+        { 8,    BIT_MASK(CS01) },
+        { 64,   BIT_MASK(CS01) | BIT_MASK(CS00) },
+        { 256,  BIT_MASK(CS02) },
+        { 1024, BIT_MASK(CS02) | BIT_MASK(CS00) },
+};
 
-inline __attribute__((always_inline))
-uint8_t readNoteDivisions(const uint8_t noteIndex) {
-    divv::div(noteIndex, NOTES_COUNT);
-    const uint8_t indexMod = divv::remainder;
-    return pgm_read_byte(&(NOTES_DIVISIONS[indexMod]));
+const uint8_t TIMER0_CLOCKS_COUNT = sizeof(TIMER0_CLOCKS) / sizeof(TIMER0_CLOCKS[0]);
+
+constexpr uint32_t timer0Ticks(const uint32_t cycles, const uint8_t clockIndex) {
+    return (cycles + TIMER0_CLOCKS[clockIndex].prescaler / 2u) / TIMER0_CLOCKS[clockIndex].prescaler;
+}
+
+// fastest clock that still fits cycles into maxTicks, fastest means the finest pitch resolution
+constexpr uint8_t timer0ClockFor(const uint32_t cycles, const uint32_t maxTicks) {
+    for (uint8_t clockIndex = 0; clockIndex < TIMER0_CLOCKS_COUNT; clockIndex++) {
+        if (timer0Ticks(cycles, clockIndex) <= maxTicks) {
+            return clockIndex;
+        }
+    }
+    return TIMER0_CLOCKS_COUNT - 1u;
 }
 
 // ----------------
 
 // -------- WAVEFORM DATA --------
 
-const uint8_t WAVEFORM_LENGTH = 8u;
+// 1-bit patterns played lowest bit first, one set per length, with the same waveform indices;
+// longer ones follow the shape with a first order sigma-delta
+// noise (-DNOISE) is a Galois lfsr as wide as the pattern, stepped instead of shifted, its entry is the seed
 
-const uint8_t WAVEFORMS[] PROGMEM = {
+constexpr uint8_t WAVEFORMS_8[] = {
         0b00000000,
 
         0b11110000, // -- square
@@ -73,56 +138,604 @@ const uint8_t WAVEFORMS[] PROGMEM = {
         0b10111000, // -- sawtooth
 
         0b01110101, // -- triangle
+
+#ifdef NOISE
+        0b00000001, // -- noise
+#endif
+};
+
+constexpr uint16_t WAVEFORMS_16[] = {
+        0b0000000000000000,
+
+        0b1111111100000000, // -- square
+
+        0b1110110101001000, // -- sawtooth
+
+        0b0010101111010100, // -- triangle
+
+#ifdef NOISE
+        0b0000000000000001, // -- noise
+#endif
+};
+
+constexpr uint32_t WAVEFORMS_32[] = {
+        0x00000000u,
+
+        0xFFFF0000u, // -- square
+
+        0xFBB55220u, // -- sawtooth
+
+        0x0AAFED48u, // -- triangle
+
+#ifdef NOISE
+        0x00000001u, // -- noise
+#endif
+};
+
+const uint8_t WAVEFORMS_COUNT = sizeof(WAVEFORMS_8) / sizeof(WAVEFORMS_8[0]);
+
+static_assert(WAVEFORMS_COUNT == sizeof(WAVEFORMS_16) / sizeof(WAVEFORMS_16[0])
+              && WAVEFORMS_COUNT == sizeof(WAVEFORMS_32) / sizeof(WAVEFORMS_32[0]),
+              "every length has the same waveforms");
+
+#ifdef NOISE
+const uint8_t NOISE_WAVEFORM = WAVEFORMS_COUNT - 1u;
+#endif
+
+// pattern storage of each length, a step shifts it by one,
+// noise taps give the longest sequence an lfsr of the length can run
+template<uint8_t Length>
+struct WaveformBits;
+
+template<>
+struct WaveformBits<8u> {
+    typedef uint8_t type;
+
+    static const type NOISE_TAPS = 0xB8u;
+
+    static constexpr type pattern(const uint8_t waveformIndex) {
+        return WAVEFORMS_8[waveformIndex];
+    }
+
+    inline __attribute__((always_inline))
+    static type read(const type* const address) {
+        return pgm_read_byte(address);
+    }
+};
+
+template<>
+struct WaveformBits<16u> {
+    typedef uint16_t type;
+
+    static const type NOISE_TAPS = 0xB400u;
+
+    static constexpr type pattern(const uint8_t waveformIndex) {
+        return WAVEFORMS_16[waveformIndex];
+    }
+
+    inline __attribute__((always_inline))
+    static type read(const type* const address) {
+        return pgm_read_word(address);
+    }
+};
+
+template<>
+struct WaveformBits<32u> {
+    typedef uint32_t type;
+
+    static const type NOISE_TAPS = 0x80200003u;
+
+    static constexpr type pattern(const uint8_t waveformIndex) {
+        return WAVEFORMS_32[waveformIndex];
+    }
+
+    inline __attribute__((always_inline))
+    static type read(const type* const address) {
+        return pgm_read_dword(address);
+    }
+};
+
+const uint8_t WAVEFORM_LENGTH = WAVE_STEPS;
+
+typedef WaveformBits<WAVEFORM_LENGTH> WaveformStorage;
+
+typedef WaveformStorage::type Waveform;
+
+struct WaveformData {
+    Waveform pattern;
+
+#ifdef NOISE
+    // zero for patterns
+    Waveform noiseTaps;
+#endif
 };
 
-const uint8_t WAVEFORMS_COUNT = sizeof(WAVEFORMS) / sizeof(uint8_t);
+struct WaveformsData {
+    WaveformData waveforms[WAVEFORMS_COUNT];
+
+    constexpr WaveformsData() : waveforms() {
+        for (uint8_t waveformIndex = 0; waveformIndex < WAVEFORMS_COUNT; waveformIndex++) {
+            waveforms[waveformIndex].pattern = WaveformStorage::pattern(waveformIndex);
+#ifdef NOISE
+            waveforms[waveformIndex].noiseTaps = NOISE_WAVEFORM == waveformIndex ? WaveformStorage::NOISE_TAPS : 0;
+#endif
+        }
+    }
+};
+
+constexpr WaveformsData WAVEFORMS PROGMEM = WaveformsData();
 
 inline __attribute__((always_inline))
-uint8_t readWaveform(const uint8_t waveformIndex) {
-    divv::div(waveformIndex, WAVEFORMS_COUNT);
-    const uint8_t indexMod = divv::remainder;
-    return pgm_read_byte(&(WAVEFORMS[indexMod]));
+const WaveformData* waveformFor(const uint8_t waveformIndex) {
+    return &(WAVEFORMS.waveforms[ConstDiv<WAVEFORMS_COUNT>::mod(waveformIndex)]);
+}
+
+// ----------------
+
+// -------- TEMPO DATA --------
+
+// notes last a whole number of subdivisions, SUBDIVISIONS_PER_BEAT make a beat
+const uint8_t SUBDIVISIONS_PER_BEAT = 4u;
+
+// beats per minute, 0 is the 1/8 s beat, going up is faster, going down from 0 wraps to slower
+constexpr uint16_t TEMPOS_BPM[] = { 480, 528, 576, 640, 320, 384, 416, 448 };
+
+const uint8_t TEMPOS_COUNT = sizeof(TEMPOS_BPM) / sizeof(TEMPOS_BPM[0]);
+
+// cpu cycles of a subdivision of the slowest and of the fastest tempo
+constexpr uint32_t subdivisionCycles(const bool isSlowest) {
+    uint16_t bpm = TEMPOS_BPM[0];
+    for (const uint16_t tempoBpm : TEMPOS_BPM) {
+        bpm = (tempoBpm < bpm) == isSlowest ? tempoBpm : bpm;
+    }
+    return static_cast<uint32_t>(F_CPU * 60ull / (bpm * SUBDIVISIONS_PER_BEAT));
+}
+
+// beat clock time is 16-bit fixed point, an engine time unit of UnitCycles cpu cycles has as many fraction bits
+// as the slowest subdivision leaves room for, so every tempo is exact to a fraction of a unit
+// and beats do not drift from the clock the units are counted on
+// (the cpu clock for Timer0 units, the watchdog oscillator for system ticks)
+constexpr uint8_t beatClockFractionBits(const uint32_t unitCycles) {
+    uint8_t bits = 0;
+    while (bits < 15u && (static_cast<uint64_t>(subdivisionCycles(true)) << (bits + 1u)) / unitCycles <= 0xFFFFu) {
+        bits++;
+    }
+    return bits;
 }
 
+// subdivision of every tempo in fixed point engine time units of UnitCycles cpu cycles
+template<uint32_t UnitCycles>
+struct TemposData {
+    uint16_t subdivisionTimes[TEMPOS_COUNT];
+
+    constexpr TemposData() : subdivisionTimes() {
+        for (uint8_t tempo = 0; tempo < TEMPOS_COUNT; tempo++) {
+            const uint64_t divisor = static_cast<uint64_t>(UnitCycles) * TEMPOS_BPM[tempo] * SUBDIVISIONS_PER_BEAT;
+            subdivisionTimes[tempo] = static_cast<uint16_t>(
+                    ((F_CPU * 60ull << beatClockFractionBits(UnitCycles)) + divisor / 2u) / divisor);
+        }
+    }
+};
+
 // ----------------
 
 // -------- WAVEFORM GEN --------
 
 namespace WaveformGen {
+    // indices are taken modulo NOTES_COUNT, WAVEFORMS_COUNT and TEMPOS_COUNT by the engine,
+    // waveform index 0 is silence
     struct NoteInfo {
-        uint8_t noteDivisions;
+        uint8_t noteIndex;
 
-        uint8_t waveform;
+        uint8_t waveformIndex;
 
+        // sweep and slide, see m-toolbox/Glide.h
         uint8_t bend;
+
+        // subdivisions, at least 1
+        uint8_t duration;
+
+        uint8_t tempo;
+
+        // note of the second voice, along with the note and for as long, 0 is silent
+        uint8_t secondNoteIndex;
     };
 
+    // only DUO plays the second voice, the others never look at it
+    const uint8_t VOICES_COUNT = WAVEFORM_ENGINE == WAVEFORM_ENGINE_DUO ? 2u : 1u;
+
+    // note the main logic plays next, the same one until advanceNoteSource(), called from the main loop
     inline __attribute__((always_inline))
     extern NoteInfo nextNoteSource();
 
+    // the note nextNoteSource() returned has started, the main logic moves on to the one after it
+    inline __attribute__((always_inline))
+    extern void advanceNoteSource();
+
+    // called once by Main::init() with interrupts still off from reset, enables them
     void restartGenerator();
+
+    // nominal SystemTick period, 2K cycles of 128 kHz watchdog oscillator
+    const uint32_t SYSTEM_TICK_CYCLES = F_CPU / 1000u * 16u;
+
+    // called from the main loop once per system tick: glides step and stopped rests are counted here,
+    // engines counting beats in system ticks change notes here
+    void onMainLoopTick();
+
+    // engines playing notes from an interrupt take the next one from a slot the main loop has filled
+    // a note ahead, as the note before ends; the main loop then fills the slot again with onNoteTaken()
+    bool isNoteTaken();
+
+    void onNoteTaken();
+
+    // nextNoteSource() returns another note than it did, the note in the slot is put together again
+    void onNoteSourceChanged();
+
+    // silent notes stop Timer0 and beats are counted in system ticks, MCU can power down meanwhile
+    // (CTC and DDS only with -DREST_POWER_DOWN)
+    bool isSuspended();
+
+    // the engine's interrupt has to be served within this many cycles from its flag,
+    // whatever handler it waits behind, checked against disassembly by `make isr_budget`
+    struct InterruptBudget {
+        uint8_t vectorNumber;
+
+        uint32_t cycles;
+    };
+
+    InterruptBudget interruptBudget();
+
+    // beat clock length of a note
+    struct NoteTiming {
+        uint16_t subdivisionTime;
+
+        uint8_t subdivisions;
+    };
+
+    // counts down the subdivisions of the playing note in fixed point engine time units,
+    // what a note overshoots its end by is taken off the next one, so beats stay on the grid
+    // whatever the periods the engine reports time in; a note carries its subdivision length,
+    // so advancing costs a compare and a subtraction
+    template<uint32_t UnitCycles>
+    class BeatClock {
+    public:
+        // true once the note has ended, and on every advance after that until start():
+        // a note the engine has no next one for goes on, and the wait comes off the next note;
+        // elapsed is shorter than any subdivision (engines assert it), so it ends one subdivision at most
+        inline __attribute__((always_inline))
+        bool advance(const uint16_t elapsed) {
+            const bool isSubdivisionEnd = elapsed >= remaining;
+            remaining -= elapsed;
+            if (isSubdivisionEnd) {
+                remaining += subdivisionTime;
+                if (0 != subdivisionsLeft) {
+                    subdivisionsLeft--;
+                }
+            }
+            return 0 == subdivisionsLeft;
+        }
+
+        // what the note before overshot its end by comes off the new one,
+        // a wait longer than its first subdivision ends that right away
+        inline __attribute__((always_inline))
+        void start(const NoteTiming& timing) {
+            const uint16_t overshoot = subdivisionTime - remaining;
+            remaining = overshoot < timing.subdivisionTime ? timing.subdivisionTime - overshoot : 0;
+            subdivisionTime = timing.subdivisionTime;
+            subdivisionsLeft = timing.subdivisions;
+        }
+
+        // the note ends before time has elapsed
+        inline __attribute__((always_inline))
+        bool isEndingWithin(const uint16_t time) const {
+            return 1u == subdivisionsLeft && remaining <= time;
+        }
+
+        // read from flash by the main loop
+        inline __attribute__((always_inline))
+        static NoteTiming timingOf(const NoteInfo& note) {
+            const uint8_t tempo = ConstDiv<TEMPOS_COUNT>::mod(note.tempo);
+            return NoteTiming { pgm_read_word(&(TEMPOS.subdivisionTimes[tempo])), note.duration };
+        }
+
+        // elapsed time of a whole number of units
+        static constexpr uint16_t units(const uint32_t count) {
+            return static_cast<uint16_t>(count << beatClockFractionBits(UnitCycles));
+        }
+
+        // count whole units are shorter than the fastest subdivision, as anything passed to advance() has to be
+        static constexpr bool isShorterThanSubdivisions(const uint32_t count) {
+            return (static_cast<uint64_t>(count) * UnitCycles) < subdivisionCycles(false);
+        }
+
+    private:
+        static const TemposData<UnitCycles> TEMPOS;
+
+        // starts as if a note had just ended, the first advance asks for a note
+        uint16_t remaining = 0;
+
+        uint16_t subdivisionTime = 0;
+
+        uint8_t subdivisionsLeft = 0;
+    };
+
+    template<uint32_t UnitCycles>
+    const TemposData<UnitCycles> BeatClock<UnitCycles>::TEMPOS PROGMEM = TemposData<UnitCycles>();
+}
+
+#if WAVEFORM_ENGINE == WAVEFORM_ENGINE_CTC
+
+// -------- CTC NOTES DATA --------
+
+// a wave period is a silent segment followed by WAVEFORM_LENGTH waveform steps,
+// every segment is one CTC cycle of Timer0 with its own OCR0A
+// so the period can be up to WAVE_SEGMENTS * 256 ticks long (16-bit effective period), split as evenly as possible:
+// first longSegments segments last one tick longer than the rest
+// a note's period is kept as its segment length in ticks, 8.8 fixed point, which is what glides move:
+// the integer part is compare + 1, the fraction times WAVE_SEGMENTS is longSegments
+// the level of each segment is put on OC0A (PB0) by the compare match that ends the segment before,
+// the segment interrupt only picks set or clear for the next match, so edges do not wait for it
+
+const uint8_t WAVE_SEGMENTS = WAVEFORM_LENGTH + 1u;
+
+const uint16_t WAVE_PERIOD_MAX_TICKS = WAVE_SEGMENTS * 256u - 1u;
+
+static_assert(0 == (WAVEFORM_LENGTH & (WAVEFORM_LENGTH - 1u)), "segments are multiplied by shift and add");
+
+// worst case of the segment interrupt as `make isr_budget_steps` reports it for every waveform length:
+// its own longest path, interrupt entry, the longest other handler and the longest main loop cli window
+// it may have to wait for (an image built with clang's AVR backend, avr-gcc's may come out longer);
+// a change that makes the interrupt longer fails the isr budget until these are measured again
+#if WAVE_STEPS == 32
+const uint16_t SEGMENT_INTERRUPT_CYCLES = 281u;
+#elif WAVE_STEPS == 16
+const uint16_t SEGMENT_INTERRUPT_CYCLES = 245u;
+#else
+const uint16_t SEGMENT_INTERRUPT_CYCLES = 230u;
+#endif
+
+// time is counted in units of the fastest Timer0 clock
+const uint8_t TIME_UNIT_CYCLES = 8u;
+
+// shortest segment has to outlast the segment interrupt, counted in ticks of the fastest clock,
+// which holds a segment of as many ticks on any slower clock too
+const uint8_t WAVE_SEGMENT_MIN_COMPARE = (SEGMENT_INTERRUPT_CYCLES + TIME_UNIT_CYCLES - 1u) / TIME_UNIT_CYCLES - 1u;
+
+constexpr uint8_t log2(const uint16_t value) {
+    return value <= 1u ? 0u : 1u + log2(value >> 1u);
+}
+
+// log2(pre-scaler / TIME_UNIT_CYCLES) of the slowest clock a note plays on
+constexpr uint8_t slowestNoteTimeShift() {
+    uint8_t timeShift = 0;
+    for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+        const uint8_t clockIndex = timer0ClockFor(noteCycles(noteIndex), WAVE_PERIOD_MAX_TICKS);
+        const uint8_t noteTimeShift = log2(TIMER0_CLOCKS[clockIndex].prescaler / TIME_UNIT_CYCLES);
+        timeShift = noteTimeShift > timeShift ? noteTimeShift : timeShift;
+    }
+    return timeShift;
+}
+
+// a wave period has to be shorter than the shortest subdivision, the beat clock ends one subdivision a period
+// at most: segments on the slowest clock are kept that short, glides included;
+// long segments use compare + 1
+constexpr uint8_t segmentMaxCompare() {
+    const uint32_t periodCycles = static_cast<uint32_t>(WAVE_SEGMENTS) * TIME_UNIT_CYCLES << slowestNoteTimeShift();
+    const uint32_t segmentTicks = (subdivisionCycles(false) - 1u) / periodCycles;
+    return segmentTicks < 2u ? 0 : segmentTicks - 2u < 254u ? static_cast<uint8_t>(segmentTicks - 2u) : 254u;
+}
+
+const uint8_t WAVE_SEGMENT_MAX_COMPARE = segmentMaxCompare();
+
+// rests play silent periods at the fastest clock, ~0.5 ms each;
+// with -DREST_POWER_DOWN they stop the timer for whole system ticks and time only what is left of the last one
+const uint8_t SILENT_SEGMENT_COMPARE = 63u;
+
+static_assert(SILENT_SEGMENT_COMPARE >= WAVE_SEGMENT_MIN_COMPARE && SILENT_SEGMENT_COMPARE <= WAVE_SEGMENT_MAX_COMPARE,
+              "silent segments are played like any other");
+
+// ~3.5 cents
+const uint32_t NOTES_MAX_PITCH_ERROR_PPM = 2000u;
+
+const uint16_t SEGMENT_TIME_MIN = (WAVE_SEGMENT_MIN_COMPARE + 1u) << 8u;
+
+const uint16_t SEGMENT_TIME_MAX = ((WAVE_SEGMENT_MAX_COMPARE + 1u) << 8u) | 0xFFu;
+
+inline __attribute__((always_inline))
+constexpr uint8_t segmentCompareOf(const uint16_t segmentTime) {
+    return static_cast<uint8_t>((segmentTime >> 8u) - 1u);
+}
+
+// fraction * WAVE_SEGMENTS >> 8 with a shift and an add, there is no multiplier
+inline __attribute__((always_inline))
+constexpr uint8_t longSegmentsOf(const uint16_t segmentTime) {
+    return static_cast<uint8_t>(((static_cast<uint16_t>(static_cast<uint8_t>(segmentTime)) << log2(WAVEFORM_LENGTH))
+            + static_cast<uint8_t>(segmentTime)) >> 8u);
+}
+
+// smallest fraction giving longSegments back
+constexpr uint16_t segmentTimeOf(const uint8_t segmentCompare, const uint8_t longSegments) {
+    return static_cast<uint16_t>(((segmentCompare + 1u) << 8u) + (longSegments * 256u + WAVE_SEGMENTS - 1u) / WAVE_SEGMENTS);
 }
 
+// entry of rests, after the notes
+const uint8_t REST_PERIOD_INDEX = NOTES_COUNT;
+
+// a note is kept as the segment interrupt plays it, only glides put segments together at runtime;
+// a table per field, so a note index needs no multiply
+struct NotesPeriodsData {
+    uint8_t clockSelects[NOTES_COUNT + 1u];
+
+    uint8_t segmentCompares[NOTES_COUNT + 1u];
+
+    uint8_t longSegments[NOTES_COUNT + 1u];
+
+    // beat clock units
+    uint16_t periodTimes[NOTES_COUNT + 1u];
+
+#ifdef GLIDE
+    // 8.8 fixed point ticks, notes only
+    uint16_t segmentTimes[NOTES_COUNT];
+
+    // log2(pre-scaler / TIME_UNIT_CYCLES), notes only
+    uint8_t timeShifts[NOTES_COUNT];
+#endif
+
+    constexpr NotesPeriodsData() : clockSelects(), segmentCompares(), longSegments(), periodTimes()
+#ifdef GLIDE
+            , segmentTimes(), timeShifts()
+#endif
+    {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            const uint32_t cycles = noteCycles(noteIndex);
+            const uint8_t clockIndex = timer0ClockFor(cycles, WAVE_PERIOD_MAX_TICKS);
+            const uint32_t ticks = timer0Ticks(cycles, clockIndex);
+            const uint16_t segmentTime = segmentTimeOf(
+                    static_cast<uint8_t>(ticks / WAVE_SEGMENTS - 1u), static_cast<uint8_t>(ticks % WAVE_SEGMENTS));
+            const uint8_t timeShift = log2(TIMER0_CLOCKS[clockIndex].prescaler / TIME_UNIT_CYCLES);
+            clockSelects[noteIndex] = TIMER0_CLOCKS[clockIndex].clockSelect;
+            segmentCompares[noteIndex] = segmentCompareOf(segmentTime);
+            longSegments[noteIndex] = longSegmentsOf(segmentTime);
+            periodTimes[noteIndex] = WaveformGen::BeatClock<TIME_UNIT_CYCLES>::units(static_cast<uint32_t>(
+                    (segmentCompares[noteIndex] + 1u) * WAVE_SEGMENTS + longSegments[noteIndex]) << timeShift);
+#ifdef GLIDE
+            segmentTimes[noteIndex] = segmentTime;
+            timeShifts[noteIndex] = timeShift;
+#endif
+        }
+        // silent periods run on the fastest clock, a tick is a time unit
+        clockSelects[REST_PERIOD_INDEX] = TIMER0_CLOCKS[0].clockSelect;
+        segmentCompares[REST_PERIOD_INDEX] = SILENT_SEGMENT_COMPARE;
+        longSegments[REST_PERIOD_INDEX] = 0;
+        periodTimes[REST_PERIOD_INDEX] = WaveformGen::BeatClock<TIME_UNIT_CYCLES>::units(
+                (SILENT_SEGMENT_COMPARE + 1u) * WAVE_SEGMENTS);
+    }
+
+    // segment times between SEGMENT_TIME_MIN and SEGMENT_TIME_MAX
+    constexpr bool isPlayable() const {
+        for (const uint8_t segmentCompare : segmentCompares) {
+            if (segmentCompare < WAVE_SEGMENT_MIN_COMPARE || segmentCompare > WAVE_SEGMENT_MAX_COMPARE) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // from the period the beat clock counts, so a period overflowing it is off too
+    constexpr bool isAccurate() const {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            const uint32_t units = periodTimes[noteIndex] >> beatClockFractionBits(TIME_UNIT_CYCLES);
+            if (pitchErrorPpm(noteCycles(noteIndex), units * TIME_UNIT_CYCLES) > NOTES_MAX_PITCH_ERROR_PPM) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+constexpr NotesPeriodsData NOTES_PERIODS PROGMEM = NotesPeriodsData();
+
+static_assert(NOTES_PERIODS.isPlayable(),
+              "note segments must fit OCR0A and outlast SEGMENT_INTERRUPT_CYCLES, fewer WAVE_STEPS or lower notes fix it");
+
+static_assert(NOTES_PERIODS.isAccurate(), "every note must be within a few cents of its frequency");
+
+// ----------------
+
 namespace WaveformGen {
     namespace {
-        const uint16_t TIMER_PRESCALER = 1024;
+        typedef BeatClock<TIME_UNIT_CYCLES> CtcBeatClock;
 
-        const uint16_t TIMER_COUNTS_IN_SECOND = F_CPU / TIMER_PRESCALER;
+        const uint16_t SYSTEM_TICK_TIME = CtcBeatClock::units(SYSTEM_TICK_CYCLES / TIME_UNIT_CYCLES);
 
-        const uint16_t TIMER_COUNTS_PER_BEAT = TIMER_COUNTS_IN_SECOND / 8;
+        static_assert(CtcBeatClock::isShorterThanSubdivisions(SYSTEM_TICK_CYCLES / TIME_UNIT_CYCLES)
+                      && CtcBeatClock::isShorterThanSubdivisions(
+                              ((WAVE_SEGMENT_MAX_COMPARE + 2u) * WAVE_SEGMENTS) << slowestNoteTimeShift()),
+                      "a system tick and a wave period end one subdivision at most");
+
+#ifdef GLIDE
+        typedef Glide<SEGMENT_TIME_MIN, SEGMENT_TIME_MAX, true> SegmentGlide;
+#endif
 
         typedef OutputPin<DDRB, PORTB, PINB, 0> blinkerPin;
 
+        // what the segment interrupt plays a period with
+        struct SegmentTiming {
+            uint8_t segmentCompare;
+
+            uint8_t longSegments;
+
+            // beat clock units
+            uint16_t periodTime;
+        };
+
+        // segments follow the glide, a period at a time
+        struct ActiveNote {
+            SegmentTiming segments;
+
+            Waveform waveform;
+
+#ifdef NOISE
+            Waveform noiseTaps;
+#endif
+        };
+
+        // put together by the main loop a note ahead, taken by the segment interrupt as the note before ends
+        struct PreparedNote {
+            SegmentTiming segments;
+
+            Waveform waveform;
+
+#ifdef NOISE
+            Waveform noiseTaps;
+#endif
+
+            NoteTiming timing;
+
+            // TCCR0B
+            uint8_t clockSelect;
+
+#ifdef GLIDE
+            // only keeps its slide when there is something to slide from,
+            // a sliding note goes on with the segments of the note before
+            uint8_t bend;
+#endif
+        };
+
         struct WaveformGeneratorState {
-            uint16_t timeCounter = 0;
+            CtcBeatClock beatClock;
+
+            ActiveNote activeNote = {};
+
+#ifdef GLIDE
+            // where the glide has got to, taken at the end of a period;
+            // the main loop writes it while isGlided is clear, the interrupt clears isGlided once it took it
+            SegmentTiming glidedSegments = {};
+
+            volatile bool isGlided = false;
+#endif
+
+            uint8_t segmentIndex = 0;
+
+            Waveform liveWaveform = 0;
+
+            PreparedNote nextNote = {};
 
-            WaveformGen::NoteInfo activeNote = { 0, 0, 0 };
+            // set by the interrupt taking nextNote, the main loop clears it once the next one is there
+            volatile bool isNoteTaken = false;
 
-            uint8_t waveformStepDivisions = 0;
+            // set by the main loop while it puts nextNote together again, the interrupt does not take it then
+            volatile bool isNoteRewriting = false;
 
-            uint8_t liveWaveform = 0;
+#ifdef GLIDE
+            // main loop side, the glide of the note playing
+            SegmentGlide glide;
 
-            uint8_t divider = 0;
+            uint8_t glideTimeShift = 0;
+
+            // of nextNote
+            uint8_t nextNoteIndex = 0;
+#endif
         };
 
         WaveformGeneratorState wgs;
@@ -131,116 +744,1109 @@ namespace WaveformGen {
         // depending if data is "packed" or "flat"
         // seems to be affected by members in the struct too
         /*
-        uint16_t _timeCounter = 0;
+        ActiveNote _activeNote = {};
+
+        Waveform _liveWaveform = 0;
+        */
+
+        inline __attribute__((always_inline))
+        ActiveNote& activeNote() {
+            //return _activeNote;
+            return wgs.activeNote;
+        }
+
+        inline __attribute__((always_inline))
+        Waveform& liveWaveform() {
+            //return _liveWaveform;
+            return wgs.liveWaveform;
+        }
+
+#ifdef GLIDE
+        // what NotesPeriodsData works out for notes, for where a glide has got to
+        __attribute__((noinline))
+        SegmentTiming segmentTimingOf(const uint16_t segmentTime, const uint8_t timeShift) {
+            const uint8_t segmentCompare = segmentCompareOf(segmentTime);
+            const uint8_t longSegments = longSegmentsOf(segmentTime);
+            // times WAVE_SEGMENTS by shift and add, and a period fits 16 bits on any clock:
+            // no multiply or 32-bit shift, which would take registers the main loop stack has to save
+            const uint16_t segmentTicks = segmentCompare + 1u;
+            const uint16_t periodTicks = (segmentTicks << log2(WAVEFORM_LENGTH)) + segmentTicks + longSegments;
+            return SegmentTiming { segmentCompare, longSegments,
+                                   CtcBeatClock::units(static_cast<uint16_t>(periodTicks << timeShift)) };
+        }
+#endif
+
+        // CTC with OC0A cleared on compare match, COM0A0 turns it into set
+        const uint8_t SEGMENT_END_CLEAR = BIT_MASK(WGM01) | BIT_MASK(COM0A1);
+
+        // level OC0A takes when the current segment ends,
+        // past the last step a pattern is shifted out and the silent segment gets a zero;
+        // noise feeds the bit shifted out back through its taps, which are zero for patterns,
+        // the shift and the feedback take a cycle or two per byte of the pattern, the same at every step
+        inline __attribute__((always_inline))
+        void onWaveStep() {
+            const Waveform waveform = liveWaveform();
+            const bool wfBit = waveform & 0b1u;
+            ACCESS_BYTE(TCCR0A) = wfBit ? SEGMENT_END_CLEAR | BIT_MASK(COM0A0) : SEGMENT_END_CLEAR;
+#ifdef NOISE
+            liveWaveform() = wfBit ? (waveform >> 1u) ^ activeNote().noiseTaps : waveform >> 1u;
+#else
+            liveWaveform() = waveform >> 1u;
+#endif
+        }
+
+        // noise runs on across periods, it is seeded when a pattern has left it at zero
+        inline __attribute__((always_inline))
+        void primeNextWavePeriod() {
+#ifdef NOISE
+            if (0 == activeNote().noiseTaps || 0 == liveWaveform()) {
+                liveWaveform() = activeNote().waveform;
+            }
+#else
+            liveWaveform() = activeNote().waveform;
+#endif
+        }
+
+        inline __attribute__((always_inline))
+        void loadSegmentCompare() {
+            const uint8_t segmentCompare = activeNote().segments.segmentCompare;
+            ACCESS_BYTE(OCR0A) = wgs.segmentIndex < activeNote().segments.longSegments ? segmentCompare + 1u : segmentCompare;
+        }
+
+        // a rest plays silent periods, with -DREST_POWER_DOWN one longer than a system tick stops the timer instead,
+        // the main loop starts it again less than a tick before the rest ends (see onMainLoopTick());
+        // the note is taken in the silent segment, a pattern has left OC0A low, noise may not have:
+        // a forced clear match takes it low and it stays so with the timer stopped,
+        // and system ticks count the rest from its start
+        inline __attribute__((always_inline))
+        void takeNextNote() {
+            const PreparedNote& next = wgs.nextNote;
+#ifdef GLIDE
+            if (0 == (next.bend & GlideDetails::SLIDE)) {
+                activeNote().segments = next.segments;
+            }
+#else
+            activeNote().segments = next.segments;
+#endif
+            activeNote().waveform = next.waveform;
+#ifdef NOISE
+            activeNote().noiseTaps = next.noiseTaps;
+#endif
+            wgs.beatClock.start(next.timing);
+            wgs.isNoteTaken = true;
+            uint8_t clockSelect = next.clockSelect;
+#ifdef REST_POWER_DOWN
+            if (0 == next.waveform && !wgs.beatClock.isEndingWithin(SYSTEM_TICK_TIME)) {
+                ACCESS_BYTE(TCCR0A) = SEGMENT_END_CLEAR;
+                clockSelect = BIT_MASK(FOC0A);
+                wdt_reset();
+            }
+#endif
+            // the counter has run on the old clock since the segment started, about 150 cycles of latency,
+            // and the pre-scaler is not reset: a segment starting another clock has those ticks at the old rate
+            // and its first tick anywhere within one of the new clock. To a slower clock it comes out shorter
+            // by the latency times the ratio less one (~0.1 ms from /8 to /64), to a faster one a little longer;
+            // beats take it as it is. Notes of one clock (C5 and up with /8) are not affected, resetting
+            // the pre-scaler and TCNT0 on a change does not fit 1 KB
+            ACCESS_BYTE(TCCR0B) = clockSelect;
+        }
+
+        // a note the main loop has not put together yet is taken at a later period end, the beat clock
+        // takes the wait off it; glided segments left from the note before a taken one are dropped by the main loop
+        inline __attribute__((always_inline))
+        void onWavePeriodEnd() {
+            if (wgs.beatClock.advance(activeNote().segments.periodTime) && !wgs.isNoteTaken && !wgs.isNoteRewriting) {
+                takeNextNote();
+#ifdef GLIDE
+            } else if (wgs.isGlided && !wgs.isNoteTaken) {
+                activeNote().segments = wgs.glidedSegments;
+                wgs.isGlided = false;
+#endif
+            }
+            primeNextWavePeriod();
+        }
+
+        // compare B sits at BOTTOM, so it fires as each segment starts,
+        // once the counter has cleared and OCR0A can no longer affect the segment that ended
+        // (and once OC0A has already switched to the level of the segment that starts)
+        inline __attribute__((always_inline))
+        void onSegmentStart() {
+            uint8_t segmentIndex = wgs.segmentIndex + 1u;
+            if (WAVE_SEGMENTS == segmentIndex) {
+                segmentIndex = 0;
+                onWavePeriodEnd();
+            }
+            wgs.segmentIndex = segmentIndex;
+            loadSegmentCompare();
+            onWaveStep();
+        }
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunknown-attributes"
+        ISR(TIM0_COMPB_vect) {
+            onSegmentStart();
+        }
+#pragma clang diagnostic pop
+
+        // the interrupt does not touch nextNote while isNoteTaken or isNoteRewriting is set
+        inline __attribute__((always_inline))
+        void fillNextNote() {
+            const NoteInfo note = nextNoteSource();
+            PreparedNote& next = wgs.nextNote;
+            next.timing = CtcBeatClock::timingOf(note);
+            // a rest plays the silent pattern with the rest entry
+            const bool isRest = 0 == ConstDiv<WAVEFORMS_COUNT>::mod(note.waveformIndex);
+            const uint8_t noteIndex = isRest ? REST_PERIOD_INDEX : ConstDiv<NOTES_COUNT>::mod(note.noteIndex);
+            next.segments = SegmentTiming {
+                    pgm_read_byte(&(NOTES_PERIODS.segmentCompares[noteIndex])),
+                    pgm_read_byte(&(NOTES_PERIODS.longSegments[noteIndex])),
+                    pgm_read_word(&(NOTES_PERIODS.periodTimes[noteIndex])) };
+            next.clockSelect = pgm_read_byte(&(NOTES_PERIODS.clockSelects[noteIndex]));
+            const WaveformData* const waveform = waveformFor(note.waveformIndex);
+            next.waveform = WaveformStorage::read(&(waveform->pattern));
+#ifdef NOISE
+            next.noiseTaps = WaveformStorage::read(&(waveform->noiseTaps));
+#endif
+#ifdef GLIDE
+            if (isRest) {
+                next.bend = 0;
+                return;
+            }
+            wgs.nextNoteIndex = noteIndex;
+            // segment times of different clocks do not compare, and a rest has none:
+            // notes after a rest or on another clock start at their pitch
+            const bool canSlide = ACCESS_BYTE(TCCR0B) == next.clockSelect && 0 != activeNote().waveform;
+            next.bend = canSlide ? note.bend : note.bend & ~GlideDetails::SLIDE;
+#endif
+        }
 
-        WaveformGen::NoteInfo _activeNote = { 0, 0 };
+        // puts the next note together and hands it to the interrupt
+        __attribute__((noinline))
+        void prepareNote() {
+            fillNextNote();
+            MEMORY_BARRIER();
+            wgs.isNoteTaken = false;
+        }
+    }
+
+    inline __attribute__((always_inline))
+    void restartGenerator() {
+        blinkerPin::init();
+
+        // set timer counter mode to CTC, OC0A low until the first step
+        ACCESS_BYTE(TCCR0A) = SEGMENT_END_CLEAR;
+
+        // segment interrupt at BOTTOM, OCR0B is 0 from reset; the only Timer0 interrupt
+        ACCESS_BYTE(TIMSK0) = BIT_MASK(OCIE0B);
+
+        // first segment ends a period and takes the first note, which sets the timer clock
+        wgs.segmentIndex = WAVE_SEGMENTS - 1u;
+        prepareNote();
+
+        // set pre-scaler to 1024 and start timer
+        ACCESS_BYTE(TCCR0B) = BIT_MASK(CS02) | BIT_MASK(CS00);
+
+        sei();
+    }
+
+    inline __attribute__((always_inline))
+    bool isSuspended() {
+#ifdef REST_POWER_DOWN
+        return 0 == (ACCESS_BYTE(TCCR0B) & (BIT_MASK(CS02) | BIT_MASK(CS01) | BIT_MASK(CS00)));
+#else
+        return false;
+#endif
+    }
+
+    inline __attribute__((always_inline))
+    bool isNoteTaken() {
+        return wgs.isNoteTaken;
+    }
+
+    // the glide starts from the segments the interrupt has just taken, or slides on from the ones it kept
+    inline __attribute__((always_inline))
+    void onNoteTaken() {
+#ifdef GLIDE
+        wgs.glide.start(pgm_read_word(&(NOTES_PERIODS.segmentTimes[wgs.nextNoteIndex])), wgs.nextNote.bend, true);
+        wgs.glideTimeShift = pgm_read_byte(&(NOTES_PERIODS.timeShifts[wgs.nextNoteIndex]));
+        // the interrupt leaves isGlided alone until the next note is there
+        wgs.isGlided = false;
+#endif
+        advanceNoteSource();
+        prepareNote();
+    }
+
+    // a note the interrupt has already taken is left to onNoteTaken(), which puts the next one together anyway;
+    // the interrupt may take the note up to isNoteRewriting being set, isNoteTaken is read after it
+    inline __attribute__((always_inline))
+    void onNoteSourceChanged() {
+        wgs.isNoteRewriting = true;
+        if (!wgs.isNoteTaken) {
+            prepareNote();
+        }
+        wgs.isNoteRewriting = false;
+    }
+
+    // a stopped rest counts whole ticks, the interrupt does not run then;
+    // less than a tick before its end the timer plays silent periods for the rest of it.
+    // a glide step is handed to the interrupt as segments to take at the end of a period,
+    // a step the interrupt has not taken yet is not written over, the glide goes on to the next one;
+    // segments handed just after the interrupt has taken the next note are dropped by onNoteTaken()
+    inline __attribute__((always_inline))
+    void onMainLoopTick() {
+        if (isSuspended()) {
+            wgs.beatClock.advance(SYSTEM_TICK_TIME);
+            if (wgs.beatClock.isEndingWithin(SYSTEM_TICK_TIME)) {
+                // silent segment of a fresh period, as the interrupt left it
+                ACCESS_BYTE(TCNT0) = 0;
+                ACCESS_BYTE(TCCR0B) = TIMER0_CLOCKS[0].clockSelect;
+            }
+            return;
+        }
+#ifdef GLIDE
+        if (!wgs.glide.isMoving()) {
+            return;
+        }
+        wgs.glide.step();
+        if (!wgs.isGlided) {
+            wgs.glidedSegments = segmentTimingOf(wgs.glide.value(), wgs.glideTimeShift);
+            MEMORY_BARRIER();
+            wgs.isGlided = true;
+        }
+#endif
+    }
+
+    // segment interrupt comes every segment, it has to pick the next level before that segment's compare match;
+    // notes and bends keep segments WAVE_SEGMENT_MIN_COMPARE + 1 ticks long at least, which is what isPlayable() checks
+    InterruptBudget interruptBudget() {
+        return InterruptBudget { TIM0_COMPB_vect_num, (WAVE_SEGMENT_MIN_COMPARE + 1u) * TIME_UNIT_CYCLES };
+    }
+}
+
+#elif WAVEFORM_ENGINE == WAVEFORM_ENGINE_DDS
+
+// -------- DDS DATA --------
+
+// 16-bit phase accumulator, its top WAVETABLE_LENGTH_BITS bits index the wavetable
+const uint8_t WAVETABLE_LENGTH_BITS = 5u;
+
+const uint8_t WAVETABLE_LENGTH = 1u << WAVETABLE_LENGTH_BITS;
+
+const uint8_t WAVETABLE_SILENCE = 0x80u;
+
+#ifdef NOISE
+// noise loops a run of bytes of a 16-bit lfsr at the note's pitch
+constexpr uint8_t noiseSample(const uint8_t sampleIndex) {
+    uint16_t lfsr = 1u;
+    for (uint16_t step = 0; step < (sampleIndex + 1u) * 8u; step++) {
+        lfsr = (lfsr & 0b1u) ? (lfsr >> 1u) ^ WaveformBits<16u>::NOISE_TAPS : lfsr >> 1u;
+    }
+    return static_cast<uint8_t>(lfsr);
+}
+#endif
+
+// same waveform indices as WAVEFORMS
+constexpr uint8_t wavetableSample(const uint8_t waveformIndex, const uint8_t sampleIndex) {
+    const uint8_t half = WAVETABLE_LENGTH / 2u;
+    switch (waveformIndex) {
+        case 1: // -- square
+            return sampleIndex < half ? 0xFFu : 0x00u;
+        case 2: // -- sawtooth
+            return static_cast<uint8_t>(sampleIndex * 0xFFu / (WAVETABLE_LENGTH - 1u));
+        case 3: // -- triangle
+            return static_cast<uint8_t>(
+                    (sampleIndex < half ? sampleIndex : WAVETABLE_LENGTH - 1u - sampleIndex) * 0xFFu / (half - 1u));
+#ifdef NOISE
+        case NOISE_WAVEFORM:
+            return noiseSample(sampleIndex);
+#endif
+        default:
+            return WAVETABLE_SILENCE;
+    }
+}
+
+struct WavetablesData {
+    uint8_t samples[WAVEFORMS_COUNT][WAVETABLE_LENGTH];
+
+    constexpr WavetablesData() : samples() {
+        for (uint8_t waveformIndex = 0; waveformIndex < WAVEFORMS_COUNT; waveformIndex++) {
+            for (uint8_t sampleIndex = 0; sampleIndex < WAVETABLE_LENGTH; sampleIndex++) {
+                samples[waveformIndex][sampleIndex] = wavetableSample(waveformIndex, sampleIndex);
+            }
+        }
+    }
+};
+
+constexpr WavetablesData WAVETABLES PROGMEM = WavetablesData();
+
+inline __attribute__((always_inline))
+const uint8_t* wavetableFor(const uint8_t waveformIndex) {
+    return WAVETABLES.samples[ConstDiv<WAVEFORMS_COUNT>::mod(waveformIndex)];
+}
+
+// fast pwm without pre-scaler: one sample per 256 cpu cycles
+const uint16_t DDS_CYCLES_PER_SAMPLE = 256u;
+
+constexpr uint16_t phaseStepFor(const uint8_t noteIndex) {
+    const uint32_t periodCycles = noteCycles(noteIndex);
+    return static_cast<uint16_t>((65536ull * DDS_CYCLES_PER_SAMPLE + periodCycles / 2u) / periodCycles);
+}
+
+struct NotesPhaseStepsData {
+    uint16_t steps[NOTES_COUNT];
+
+    constexpr NotesPhaseStepsData() : steps() {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            steps[noteIndex] = phaseStepFor(noteIndex);
+        }
+    }
+
+    constexpr uint16_t lowest() const {
+        uint16_t lowest = 0xFFFFu;
+        for (const uint16_t step : steps) {
+            lowest = step < lowest ? step : lowest;
+        }
+        return lowest;
+    }
+
+    constexpr uint16_t highest() const {
+        uint16_t highest = 0;
+        for (const uint16_t step : steps) {
+            highest = step > highest ? step : highest;
+        }
+        return highest;
+    }
+};
+
+constexpr NotesPhaseStepsData NOTES_PHASE_STEPS PROGMEM = NotesPhaseStepsData();
+
+inline __attribute__((always_inline))
+uint16_t readNotePhaseStep(const uint8_t noteIndex) {
+    const uint8_t indexMod = ConstDiv<NOTES_COUNT>::mod(noteIndex);
+    return pgm_read_word(&(NOTES_PHASE_STEPS.steps[indexMod]));
+}
+
+// ----------------
+
+namespace WaveformGen {
+    namespace {
+        typedef BeatClock<DDS_CYCLES_PER_SAMPLE> DdsBeatClock;
+
+        const uint16_t SAMPLE_TIME = DdsBeatClock::units(1u);
+
+        const uint16_t SYSTEM_TICK_TIME = DdsBeatClock::units(SYSTEM_TICK_CYCLES / DDS_CYCLES_PER_SAMPLE);
+
+        static_assert(DdsBeatClock::isShorterThanSubdivisions(SYSTEM_TICK_CYCLES / DDS_CYCLES_PER_SAMPLE),
+                      "a system tick ends one subdivision at most");
+
+        // bends stay within notes range
+        const uint16_t PHASE_STEP_MIN = NOTES_PHASE_STEPS.lowest();
+
+        const uint16_t PHASE_STEP_MAX = NOTES_PHASE_STEPS.highest();
+
+#ifdef GLIDE
+        typedef Glide<PHASE_STEP_MIN, PHASE_STEP_MAX, false> PhaseStepGlide;
+#endif
+
+        // OC0A
+        typedef OutputPin<DDRB, PORTB, PINB, 0> blinkerPin;
+
+        // fast pwm, clear OC0A on compare match, set at BOTTOM
+        // OC0B stays disconnected, PB1 belongs to UI
+        const uint8_t FAST_PWM = BIT_MASK(WGM01) | BIT_MASK(WGM00);
+
+        // put together by the main loop a note ahead, taken by the sample interrupt as the note before ends
+        struct PreparedNote {
+            uint16_t phaseStep;
+
+            const uint8_t* wavetable;
+
+            NoteTiming timing;
+
+            // TCCR0A, a rest disconnects OC0A and leaves PB0 to PORTB, which is kept low
+            uint8_t compareOutput;
+
+#ifdef GLIDE
+            // only keeps its slide when there is something to slide from,
+            // a sliding note goes on with the phase step of the note before
+            uint8_t bend;
+#endif
+        };
+
+        struct WaveformGeneratorState {
+            DdsBeatClock beatClock;
+
+            uint16_t phase = 0;
+
+            // follows the glide
+            uint16_t phaseStep = 0;
+
+            const uint8_t* wavetable = WAVETABLES.samples[0];
+
+            PreparedNote nextNote = {};
+
+            // set by the interrupt taking nextNote, the main loop clears it once the next one is there
+            volatile bool isNoteTaken = false;
+
+            // set by the main loop while it puts nextNote together again, the interrupt does not take it then
+            volatile bool isNoteRewriting = false;
+
+#ifdef GLIDE
+            // where the glide has got to, taken at the next sample;
+            // the main loop writes it while isGlided is clear, the interrupt clears isGlided once it took it
+            uint16_t glidedPhaseStep = 0;
+
+            volatile bool isGlided = false;
+
+            // main loop side, its value is the phase step
+            PhaseStepGlide glide;
+#endif
+        };
+
+        WaveformGeneratorState wgs;
+
+        // a rest plays silent samples, with -DREST_POWER_DOWN one longer than a system tick stops the timer instead,
+        // the main loop starts it again less than a tick before the rest ends (see onMainLoopTick()),
+        // and system ticks count the rest from its start
+        inline __attribute__((always_inline))
+        void takeNextNote() {
+            const PreparedNote& next = wgs.nextNote;
+#ifdef GLIDE
+            if (0 == (next.bend & GlideDetails::SLIDE)) {
+                wgs.phaseStep = next.phaseStep;
+            }
+#else
+            wgs.phaseStep = next.phaseStep;
+#endif
+            wgs.wavetable = next.wavetable;
+            wgs.beatClock.start(next.timing);
+            wgs.isNoteTaken = true;
+            const uint8_t compareOutput = next.compareOutput;
+            ACCESS_BYTE(TCCR0A) = compareOutput;
+#ifdef REST_POWER_DOWN
+            if (FAST_PWM == compareOutput && !wgs.beatClock.isEndingWithin(SYSTEM_TICK_TIME)) {
+                ACCESS_BYTE(TCCR0B) = 0;
+                wdt_reset();
+            }
+#endif
+        }
+
+        // a note the main loop has not put together yet is taken at a later sample, the beat clock
+        // takes the wait off it; a glided phase step left from the note before a taken one is dropped by the main loop
+        inline __attribute__((always_inline))
+        void onSample() {
+            wgs.phase += wgs.phaseStep;
+            const uint8_t sampleIndex = static_cast<uint8_t>(wgs.phase >> 8u) >> (8u - WAVETABLE_LENGTH_BITS);
+            // double buffered by hardware, takes effect at the next BOTTOM
+            ACCESS_BYTE(OCR0A) = pgm_read_byte(wgs.wavetable + sampleIndex);
+
+            if (wgs.beatClock.advance(SAMPLE_TIME) && !wgs.isNoteTaken && !wgs.isNoteRewriting) {
+                takeNextNote();
+#ifdef GLIDE
+            } else if (wgs.isGlided && !wgs.isNoteTaken) {
+                wgs.phaseStep = wgs.glidedPhaseStep;
+                wgs.isGlided = false;
+#endif
+            }
+        }
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunknown-attributes"
+        ISR(TIM0_OVF_vect) {
+            onSample();
+        }
+#pragma clang diagnostic pop
+
+        // the interrupt does not touch nextNote while isNoteTaken or isNoteRewriting is set;
+        // a rest plays the silent wavetable, so OCR0A is at silence when the note after it connects OC0A
+        inline __attribute__((always_inline))
+        void fillNextNote() {
+            const NoteInfo note = nextNoteSource();
+            PreparedNote& next = wgs.nextNote;
+            next.timing = DdsBeatClock::timingOf(note);
+            next.wavetable = wavetableFor(note.waveformIndex);
+            if (0 == ConstDiv<WAVEFORMS_COUNT>::mod(note.waveformIndex)) {
+                next.compareOutput = FAST_PWM;
+#ifdef GLIDE
+                next.bend = 0;
+#endif
+                return;
+            }
+            next.phaseStep = readNotePhaseStep(note.noteIndex);
+            next.compareOutput = FAST_PWM | BIT_MASK(COM0A1);
+#ifdef GLIDE
+            // notes after a rest start at their pitch
+            const bool canSlide = 0 != (ACCESS_BYTE(TCCR0A) & BIT_MASK(COM0A1));
+            next.bend = canSlide ? note.bend : note.bend & ~GlideDetails::SLIDE;
+#endif
+        }
+
+        // puts the next note together and hands it to the interrupt
+        __attribute__((noinline))
+        void prepareNote() {
+            fillNextNote();
+            MEMORY_BARRIER();
+            wgs.isNoteTaken = false;
+        }
+    }
+
+    inline __attribute__((always_inline))
+    void restartGenerator() {
+        blinkerPin::init();
+
+        ACCESS_BYTE(OCR0A) = WAVETABLE_SILENCE;
+
+        ACCESS_BYTE(TCCR0A) |= FAST_PWM;
+
+        // enable overflow interrupt
+        ACCESS_BYTE(TIMSK0) |= BIT_MASK(TOIE0);
+
+        // first sample takes the first note, which connects OC0A
+        prepareNote();
+
+        // no pre-scaler, start timer
+        ACCESS_BYTE(TCCR0B) |= BIT_MASK(CS00);
+
+        sei();
+    }
+
+    inline __attribute__((always_inline))
+    bool isSuspended() {
+#ifdef REST_POWER_DOWN
+        return 0 == ACCESS_BYTE(TCCR0B);
+#else
+        return false;
+#endif
+    }
+
+    inline __attribute__((always_inline))
+    bool isNoteTaken() {
+        return wgs.isNoteTaken;
+    }
+
+    // the glide starts from the phase step the interrupt has just taken, or slides on from the one it kept
+    inline __attribute__((always_inline))
+    void onNoteTaken() {
+#ifdef GLIDE
+        wgs.glide.start(wgs.nextNote.phaseStep, wgs.nextNote.bend, true);
+        // the interrupt leaves isGlided alone until the next note is there
+        wgs.isGlided = false;
+#endif
+        advanceNoteSource();
+        prepareNote();
+    }
+
+    // a note the interrupt has already taken is left to onNoteTaken(), which puts the next one together anyway;
+    // the interrupt may take the note up to isNoteRewriting being set, isNoteTaken is read after it
+    inline __attribute__((always_inline))
+    void onNoteSourceChanged() {
+        wgs.isNoteRewriting = true;
+        if (!wgs.isNoteTaken) {
+            prepareNote();
+        }
+        wgs.isNoteRewriting = false;
+    }
+
+    // a stopped rest counts whole ticks, the interrupt does not run then;
+    // less than a tick before its end the timer plays silent samples for the rest of it, OC0A still disconnected.
+    // a glide step is handed to the interrupt as a phase step to take at the next sample,
+    // a step the interrupt has not taken yet is not written over, the glide goes on to the next one;
+    // a phase step handed just after the interrupt has taken the next note is dropped by onNoteTaken()
+    inline __attribute__((always_inline))
+    void onMainLoopTick() {
+        if (isSuspended()) {
+            wgs.beatClock.advance(SYSTEM_TICK_TIME);
+            if (wgs.beatClock.isEndingWithin(SYSTEM_TICK_TIME)) {
+                ACCESS_BYTE(TCNT0) = 0;
+                ACCESS_BYTE(TCCR0B) = BIT_MASK(CS00);
+            }
+            return;
+        }
+#ifdef GLIDE
+        if (!wgs.glide.isMoving()) {
+            return;
+        }
+        wgs.glide.step();
+        if (!wgs.isGlided) {
+            wgs.glidedPhaseStep = wgs.glide.value();
+            MEMORY_BARRIER();
+            wgs.isGlided = true;
+        }
+#endif
+    }
+
+    // one sample per overflow
+    InterruptBudget interruptBudget() {
+        return InterruptBudget { TIM0_OVF_vect_num, DDS_CYCLES_PER_SAMPLE };
+    }
+}
+
+#elif WAVEFORM_ENGINE == WAVEFORM_ENGINE_SQUARE
+
+// -------- SQUARE NOTES DATA --------
+
+// OC0A toggles on every compare match, two matches make a period
+// compare is 8-bit, so pitch is only as exact as 128..256 ticks per half period allow
+
+struct NoteToggle {
+    uint8_t clockSelect;
+
+    uint8_t compare;
+};
+
+struct NotesTogglesData {
+    NoteToggle toggles[NOTES_COUNT];
+
+    constexpr NotesTogglesData() : toggles() {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            const uint32_t halfPeriodCycles = noteCycles(noteIndex) / 2u;
+            const uint8_t clockIndex = timer0ClockFor(halfPeriodCycles, 256u);
+            toggles[noteIndex].clockSelect = TIMER0_CLOCKS[clockIndex].clockSelect;
+            toggles[noteIndex].compare = static_cast<uint8_t>(timer0Ticks(halfPeriodCycles, clockIndex) - 1u);
+        }
+    }
+};
+
+constexpr NotesTogglesData NOTES_TOGGLES PROGMEM = NotesTogglesData();
+
+// ----------------
+
+namespace WaveformGen {
+    namespace {
+        // OC0A
+        typedef OutputPin<DDRB, PORTB, PINB, 0> blinkerPin;
+
+        // system ticks are the time units, a subdivision takes a tick or two
+        typedef BeatClock<SYSTEM_TICK_CYCLES> SquareBeatClock;
+
+        static_assert(SquareBeatClock::isShorterThanSubdivisions(1u), "a system tick ends one subdivision at most");
+
+        SquareBeatClock beatClock;
+
+        // every non silent waveform plays as square, bend is not applied:
+        // nothing runs between beats to apply it
+        __attribute__((noinline))
+        void startNote() {
+            const NoteInfo note = nextNoteSource();
+            advanceNoteSource();
+            beatClock.start(SquareBeatClock::timingOf(note));
+            if (0 == ConstDiv<WAVEFORMS_COUNT>::mod(note.waveformIndex)) {
+                // disconnected OC0A leaves PB0 to PORTB, which is kept low
+                ACCESS_BYTE(TCCR0A) &= ~BIT_MASK(COM0A0);
+                ACCESS_BYTE(TCCR0B) = 0;
+            } else {
+                const NoteToggle* const toggle = &(NOTES_TOGGLES.toggles[ConstDiv<NOTES_COUNT>::mod(note.noteIndex)]);
+                ACCESS_BYTE(TCCR0B) = pgm_read_byte(&(toggle->clockSelect));
+                ACCESS_BYTE(OCR0A) = pgm_read_byte(&(toggle->compare));
+                // restart the period, lowering OCR0A below TCNT0 would run the counter through 0xFF
+                ACCESS_BYTE(TCNT0) = 0;
+                ACCESS_BYTE(TCCR0A) |= BIT_MASK(COM0A0);
+            }
+        }
+    }
+
+    inline __attribute__((always_inline))
+    void restartGenerator() {
+        blinkerPin::init();
+
+        // set timer counter mode to CTC, OC0A toggle is switched per note
+        ACCESS_BYTE(TCCR0A) |= BIT_MASK(WGM01);
+
+        // sets timer clock, which starts the timer
+        startNote();
+
+        sei();
+    }
+
+    inline __attribute__((always_inline))
+    bool isSuspended() {
+        return 0 == ACCESS_BYTE(TCCR0B);
+    }
+
+    // notes are started by the main loop, nothing is put together ahead
+    inline __attribute__((always_inline))
+    bool isNoteTaken() {
+        return false;
+    }
+
+    inline __attribute__((always_inline))
+    void onNoteTaken() {
+    }
+
+    inline __attribute__((always_inline))
+    void onNoteSourceChanged() {
+    }
+
+    inline __attribute__((always_inline))
+    void onMainLoopTick() {
+        if (beatClock.advance(SquareBeatClock::units(1u))) {
+            startNote();
+        }
+    }
+
+    // Timer0 runs on its own, only beats need serving
+    InterruptBudget interruptBudget() {
+        return InterruptBudget { WDT_vect_num, SYSTEM_TICK_CYCLES };
+    }
+}
+
+#elif WAVEFORM_ENGINE == WAVEFORM_ENGINE_DUO
+
+// -------- DUO NOTES DATA --------
+
+// Timer0 runs free at pre-scaler 8, each voice has a compare unit of its own and moves it to its next edge
+// on every match, from where the match was due rather than from when it was served, so latency never adds up;
+// a match toggles PB0, which makes PB0 the XOR of both voices
+// voices are pulses high a quarter of the period: XOR of two squares would only leave their sum and
+// difference tones, narrow pulses seldom overlap and mix close to a sum
+// a span longer than the 8-bit compare is a step of 128..255 ticks and some laps of 128 ticks,
+// so matches are never closer than the shortest span; pitch is within ~3 cents up to B7
+
+// pre-scaler 8
+const uint8_t DUO_CLOCK_INDEX = 0;
+
+const uint8_t DUO_LAP_TICKS = 128u;
+
+// time the pulse is high, of 4 quarters of the period
+const uint8_t DUO_PULSE_QUARTERS = 1u;
+
+struct NoteSpan {
+    // ticks from a toggle to the first match after it
+    uint8_t step;
+
+    // matches DUO_LAP_TICKS apart between that one and the next toggle
+    uint8_t laps;
+};
+
+struct NotePulse {
+    NoteSpan high;
+
+    NoteSpan low;
+};
+
+constexpr NoteSpan noteSpanOf(const uint32_t ticks) {
+    return ticks < 2u * DUO_LAP_TICKS
+           ? NoteSpan { static_cast<uint8_t>(ticks), 0 }
+           : NoteSpan { static_cast<uint8_t>(DUO_LAP_TICKS + ticks % DUO_LAP_TICKS),
+                        static_cast<uint8_t>(ticks / DUO_LAP_TICKS - 1u) };
+}
+
+constexpr uint32_t duoPeriodTicks(const uint8_t noteIndex) {
+    return timer0Ticks(noteCycles(noteIndex), DUO_CLOCK_INDEX);
+}
+
+constexpr uint32_t duoHighTicks(const uint8_t noteIndex) {
+    return (duoPeriodTicks(noteIndex) * DUO_PULSE_QUARTERS + 2u) / 4u;
+}
+
+struct NotesPulsesData {
+    NotePulse pulses[NOTES_COUNT];
+
+    constexpr NotesPulsesData() : pulses() {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            pulses[noteIndex].high = noteSpanOf(duoHighTicks(noteIndex));
+            pulses[noteIndex].low = noteSpanOf(duoPeriodTicks(noteIndex) - duoHighTicks(noteIndex));
+        }
+    }
+
+    // a span of 2 * DUO_LAP_TICKS or more needs 256 laps at most
+    constexpr bool isPlayable() const {
+        for (uint8_t noteIndex = 0; noteIndex < NOTES_COUNT; noteIndex++) {
+            const uint32_t lowTicks = duoPeriodTicks(noteIndex) - duoHighTicks(noteIndex);
+            if (0 == duoHighTicks(noteIndex) || lowTicks / DUO_LAP_TICKS > 0x100u) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr uint32_t shortestSpanCycles() const {
+        uint32_t shortest = DUO_LAP_TICKS;
+        for (const NotePulse& pulse : pulses) {
+            shortest = pulse.high.step < shortest ? pulse.high.step : shortest;
+            shortest = pulse.low.step < shortest ? pulse.low.step : shortest;
+        }
+        return shortest * TIMER0_CLOCKS[DUO_CLOCK_INDEX].prescaler;
+    }
+};
+
+constexpr NotesPulsesData NOTES_PULSES PROGMEM = NotesPulsesData();
+
+static_assert(NOTES_PULSES.isPlayable(), "every note must fit a pulse and 256 laps at most");
+
+// ----------------
+
+namespace WaveformGen {
+    namespace {
+        typedef OutputPin<DDRB, PORTB, PINB, 0> blinkerPin;
+
+        // the interrupt reads the spans of the note from flash, a new note takes over at the next edge
+        struct Voice {
+            const NotePulse* pulse;
+
+            uint8_t lapsLeft;
+
+            bool isHigh;
+        };
+
+        Voice voices[VOICES_COUNT];
+
+        // system ticks are the time units, a subdivision takes a tick or two
+        typedef BeatClock<SYSTEM_TICK_CYCLES> DuoBeatClock;
+
+        static_assert(DuoBeatClock::isShorterThanSubdivisions(1u), "a system tick ends one subdivision at most");
+
+        DuoBeatClock beatClock;
+
+        // voice 0 runs on compare unit A, voice 1 on B
+        template<uint8_t VoiceIndex>
+        struct VoiceUnit {
+            static const uint8_t COMPARE = 0 == VoiceIndex ? OCR0A : OCR0B;
+
+            static const uint8_t INTERRUPT = 0 == VoiceIndex ? BIT_MASK(OCIE0A) : BIT_MASK(OCIE0B);
+
+            static const uint8_t FLAG = 0 == VoiceIndex ? BIT_MASK(OCF0A) : BIT_MASK(OCF0B);
+        };
+
+        // a voice that was silent starts its first pulse a lap from now
+        template<uint8_t VoiceIndex>
+        inline __attribute__((always_inline))
+        void startVoice(const uint8_t noteIndex) {
+            typedef VoiceUnit<VoiceIndex> Unit;
+            Voice& voice = voices[VoiceIndex];
+            voice.pulse = &(NOTES_PULSES.pulses[ConstDiv<NOTES_COUNT>::mod(noteIndex)]);
+            if (0 == (ACCESS_BYTE(TIMSK0) & Unit::INTERRUPT)) {
+                ACCESS_BYTE(Unit::COMPARE) = ACCESS_BYTE(TCNT0) + DUO_LAP_TICKS;
+                voice.lapsLeft = 0;
+                // left from the last match of the unit, while the voice was silent
+                ACCESS_BYTE(TIFR0) = Unit::FLAG;
+                ACCESS_BYTE(TIMSK0) |= Unit::INTERRUPT;
+            }
+        }
+
+        // a pulse cut short ends right away, so the other voice keeps its polarity
+        template<uint8_t VoiceIndex>
+        inline __attribute__((always_inline))
+        void stopVoice() {
+            Voice& voice = voices[VoiceIndex];
+            ACCESS_BYTE(TIMSK0) &= ~VoiceUnit<VoiceIndex>::INTERRUPT;
+            if (voice.isHigh) {
+                voice.isHigh = false;
+                blinkerPin::toggle();
+            }
+        }
+
+        // every non silent waveform plays as pulses, bend is not applied;
+        // the voices are shared with the compare interrupts, which are held off meanwhile
+        __attribute__((noinline))
+        void startNote() {
+            const NoteInfo note = nextNoteSource();
+            advanceNoteSource();
+            beatClock.start(DuoBeatClock::timingOf(note));
+            cli();
+            if (0 == ConstDiv<WAVEFORMS_COUNT>::mod(note.waveformIndex)) {
+                stopVoice<0>();
+                stopVoice<1>();
+                ACCESS_BYTE(TCCR0B) = 0;
+            } else {
+                startVoice<0>(note.noteIndex);
+                if (0 == note.secondNoteIndex) {
+                    stopVoice<1>();
+                } else {
+                    startVoice<1>(note.secondNoteIndex);
+                }
+                ACCESS_BYTE(TCCR0B) = TIMER0_CLOCKS[DUO_CLOCK_INDEX].clockSelect;
+            }
+            sei();
+        }
+
+        // the compare moves on from where it was, the toggle is one write to PINB
+        template<uint8_t VoiceIndex>
+        inline __attribute__((always_inline))
+        void onVoiceMatch() {
+            typedef VoiceUnit<VoiceIndex> Unit;
+            Voice& voice = voices[VoiceIndex];
+            if (0 != voice.lapsLeft) {
+                voice.lapsLeft--;
+                ACCESS_BYTE(Unit::COMPARE) += DUO_LAP_TICKS;
+                return;
+            }
+            blinkerPin::toggle();
+            voice.isHigh = !voice.isHigh;
+            const NoteSpan* const span = voice.isHigh ? &(voice.pulse->high) : &(voice.pulse->low);
+            ACCESS_BYTE(Unit::COMPARE) += pgm_read_byte(&(span->step));
+            voice.lapsLeft = pgm_read_byte(&(span->laps));
+        }
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunknown-attributes"
+        ISR(TIM0_COMPA_vect) {
+            onVoiceMatch<0>();
+        }
+
+        ISR(TIM0_COMPB_vect) {
+            onVoiceMatch<1>();
+        }
+#pragma clang diagnostic pop
+    }
+
+    inline __attribute__((always_inline))
+    void restartGenerator() {
+        blinkerPin::init();
+
+        // normal mode, compare outputs disconnected, PB0 is PORTB's
+        ACCESS_BYTE(TCCR0A) = 0;
+
+        sei();
+
+        // sets timer clock, which starts the timer
+        startNote();
+    }
+
+    inline __attribute__((always_inline))
+    bool isSuspended() {
+        return 0 == ACCESS_BYTE(TCCR0B);
+    }
+
+    // notes are started by the main loop, nothing is put together ahead
+    inline __attribute__((always_inline))
+    bool isNoteTaken() {
+        return false;
+    }
 
-        uint8_t _liveWaveform = 0;
+    inline __attribute__((always_inline))
+    void onNoteTaken() {
+    }
 
-        uint8_t _waveformStepDivisions = 0;
-        */
+    inline __attribute__((always_inline))
+    void onNoteSourceChanged() {
+    }
 
-        inline __attribute__((always_inline))
-        uint16_t& timeCounter() {
-            //return _timeCounter;
-            return wgs.timeCounter;
+    inline __attribute__((always_inline))
+    void onMainLoopTick() {
+        if (beatClock.advance(DuoBeatClock::units(1u))) {
+            startNote();
         }
+    }
 
-        inline __attribute__((always_inline))
-        NoteInfo& activeNote() {
-            //return _activeNote;
-            return wgs.activeNote;
-        }
+    // a voice has to move its compare before the counter gets there, the shortest span after a match;
+    // the voices run the same handler, so the budget of one holds for the other
+    // (a note start holds both off in the main loop for a few register writes)
+    InterruptBudget interruptBudget() {
+        constexpr uint32_t cycles = NOTES_PULSES.shortestSpanCycles();
+        return InterruptBudget { TIM0_COMPA_vect_num, cycles };
+    }
+}
 
-        inline __attribute__((always_inline))
-        uint8_t& liveWaveform() {
-            //return _liveWaveform;
-            return wgs.liveWaveform;
-        }
+#else
+#error "unknown WAVEFORM_ENGINE"
+#endif
 
-        inline __attribute__((always_inline))
-        uint8_t& waveformStepDivisions() {
-            //return _waveformStepDivisions;
-            return wgs.waveformStepDivisions;
-        }
+// ----------------
 
-        inline __attribute__((always_inline))
-        void onWaveStep() {
-            const bool wfBit = liveWaveform() & 0b1u;
-            blinkerPin::set(wfBit);
-            liveWaveform() >>= 1u; // funny thing, moving this line changes code size
-            ACCESS_BYTE(OCR0B) += waveformStepDivisions();
-        }
+// -------- SYSTEM TICK --------
 
-        inline __attribute__((always_inline))
-        void fetchNextNote() {
-            activeNote() = nextNoteSource();
-            waveformStepDivisions() = divv::div(activeNote().noteDivisions, WAVEFORM_LENGTH + 1);
-        }
+// main loop sleeps until there is UI work:
+// watchdog interrupt every 16 ms, or a pin change when a button is pushed
+namespace SystemTick {
+    namespace {
+        // wake flags are bits of ADCSRB: its trigger source bits only count in ADC auto trigger mode
+        // and the ADC is never used, so they are spare bits sbi, cbi and sbis reach without a register;
+        // handlers setting them are one sbi and reti, as short a wait as the segment interrupt can have
+        const uint8_t TICK_DUE_BIT = ADTS0;
+
+        const uint8_t INPUT_DUE_BIT = ADTS1;
 
         inline __attribute__((always_inline))
-        void primeTimers() {
-            ACCESS_BYTE(OCR0A) = activeNote().noteDivisions;
-            ACCESS_BYTE(OCR0B) = waveformStepDivisions();
+        bool isDue(const uint8_t bit) {
+            return ACCESS_BYTE(ADCSRB) & BIT_MASK(bit);
         }
 
         inline __attribute__((always_inline))
-        void primeNextWavePeriod() {
-            blinkerPin::clear();
-            liveWaveform() = activeNote().waveform;
-            primeTimers();
-            uint8_t bend = activeNote().bend & 0b11u;
-            wgs.divider++;
-            if (0 == wgs.divider % 2) {
-                if (bend & 0b10u) {
-                    bend = ~bend + 1;
-                    activeNote().noteDivisions -= 5 * bend;
-                } else {
-                    activeNote().noteDivisions += 5 * bend;
-                }
-            }
+        void clearDue(const uint8_t bit) {
+            ACCESS_BYTE(ADCSRB) &= ~BIT_MASK(bit);
         }
 
-        inline __attribute__((always_inline))
-        void onWavePeriodEnd() {
-            timeCounter() += ACCESS_BYTE(OCR0A);
-            if (timeCounter() >= TIMER_COUNTS_PER_BEAT) {
-                timeCounter() = 0;
-                fetchNextNote();
-            }
-            primeNextWavePeriod();
+#ifdef __AVR__
+#define SYSTEM_TICK_WAKE_ISR(vector, bit) \
+        ISR(vector, ISR_NAKED) { \
+            __asm__ __volatile__ ("sbi %0, %1" "\n\t" "reti" :: "I" (_SFR_IO_ADDR(ADCSRB)), "I" (bit)); \
         }
+#else
+// host build, handlers are plain functions
+#define SYSTEM_TICK_WAKE_ISR(vector, bit) \
+        ISR(vector) { \
+            ACCESS_BYTE(ADCSRB) |= BIT_MASK(bit); \
+        }
+#endif
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunknown-attributes"
-        ISR(TIM0_COMPB_vect) {
-            onWaveStep();
-        }
+        SYSTEM_TICK_WAKE_ISR(WDT_vect, TICK_DUE_BIT)
 
-        ISR(TIM0_COMPA_vect) {
-            onWavePeriodEnd();
-        }
+        // the main loop disarms it as it wakes, until armInputWake()
+        SYSTEM_TICK_WAKE_ISR(PCINT0_vect, INPUT_DUE_BIT)
 #pragma clang diagnostic pop
     }
 
     inline __attribute__((always_inline))
-    void restartGenerator() {
-        cli();
-
-        blinkerPin::init();
-
-        // set timer counter mode to CTC
-        ACCESS_BYTE(TCCR0A) |= BIT_MASK(WGM01);
+    void init() {
+        // watchdog interrupt without reset every 2K cycles of its 128 kHz oscillator, nominally 16 ms
+        wdt_reset();
+        ACCESS_BYTE(WDTCR) = BIT_MASK(WDCE) | BIT_MASK(WDE);
+        ACCESS_BYTE(WDTCR) = BIT_MASK(WDTIE);
 
-        // enable compa & compb interrupts
-        ACCESS_BYTE(TIMSK0) |= BIT_MASK(OCIE0A) | BIT_MASK(OCIE0B);
+        // sleep mode is picked before every sleep, along with sleep enable
+    }
 
-        timeCounter() = TIMER_COUNTS_PER_BEAT;
+    // pins are watched from now on, pin changes made before are dropped;
+    // GIMSK is written whole, INT0 is not used
+    inline __attribute__((always_inline))
+    void armInputWake(const uint8_t pinsMask) {
+        ACCESS_BYTE(PCMSK) = pinsMask;
+        ACCESS_BYTE(GIFR) = BIT_MASK(PCIF);
+        ACCESS_BYTE(GIMSK) = BIT_MASK(PCIE);
+    }
 
-        // set pre-scaler to 1024 and start timer
-        ACCESS_BYTE(TCCR0B) |= BIT_MASK(CS02) | BIT_MASK(CS00);
+    inline __attribute__((always_inline))
+    void disarmInputWake() {
+        ACCESS_BYTE(GIMSK) = 0;
+    }
 
-        sei();
+    // sleeps until the next tick or input wake, returns true for a tick;
+    // a note the generator has taken is replaced with the next one first, whatever woke the loop
+    inline __attribute__((always_inline))
+    bool wait() {
+        while (true) {
+            cli();
+            if (WaveformGen::isNoteTaken()) {
+                // a stopped rest counts ticks from its start, where the watchdog was restarted,
+                // a tick due from before belongs to the note before it
+                if (WaveformGen::isSuspended()) {
+                    clearDue(TICK_DUE_BIT);
+                }
+                sei();
+                WaveformGen::onNoteTaken();
+                continue;
+            }
+            if (isDue(TICK_DUE_BIT)) {
+                clearDue(TICK_DUE_BIT);
+                sei();
+                return true;
+            }
+            if (isDue(INPUT_DUE_BIT)) {
+                clearDue(INPUT_DUE_BIT);
+                disarmInputWake();
+                sei();
+                return false;
+            }
+            // power-down stops Timer0 clock as well, so only while generator has it stopped;
+            // MCUCR is written whole, pull-ups and INT0 sense are left at their defaults
+            ACCESS_BYTE(MCUCR) = WaveformGen::isSuspended() ? BIT_MASK(SE) | BIT_MASK(SM1) : BIT_MASK(SE);
+            // sleep executes before any interrupt pending after sei, so a wake can not be missed
+            sei();
+            __builtin_avr_sleep();
+        }
     }
 }
 
@@ -262,8 +1868,17 @@ namespace UIDriver {
 
     void pollInputs();
 
+    void armInputWake();
+
     bool isRisingEdge(InputBtn btn);
 
+    // bit per button in InputBtn order
+    uint8_t risingEdges();
+
+    bool isFallingEdge(InputBtn btn);
+
+    bool isHeld(InputBtn btn);
+
     void setLEDs(bool i3, bool i2, bool i1, bool i0);
 
     void setLEDs(uint8_t val);
@@ -271,24 +1886,6 @@ namespace UIDriver {
 
 namespace UIDriver {
     namespace {
-        const uint8_t INPUT_FILTER_MASK = 0b1111111u;
-
-        const uint8_t INPUT_FILTER_MAX = INPUT_FILTER_MASK;
-
-        inline __attribute__((always_inline))
-        void filter(const bool isOn, uint8_t& value, bool& edge) {
-            if (isOn) {
-                if (value < INPUT_FILTER_MAX) {
-                    value++;
-                    if (value == INPUT_FILTER_MAX) {
-                        edge = true;
-                    }
-                }
-            } else {
-                value = 0;
-            }
-        }
-
         typedef ComboPin<DDRB, PORTB, PINB, 4> pinMode;
 
         typedef ComboPin<DDRB, PORTB, PINB, 3> pinMinus;
@@ -297,16 +1894,16 @@ namespace UIDriver {
 
         typedef ComboPin<DDRB, PORTB, PINB, 1> pinPlus;
 
-        // 7 msb bits are filter value
-        // 0th bit indicates if rising edge was detected during the latest poll
-        uint8_t buttonsState[InputButtonsCount] = { 0, 0, 0, 0 };
+        // in InputBtn order
+        typedef PinGroup<pinPlus, pinClick, pinMinus, pinMode> buttonsPins;
 
-        __attribute__((noinline))
-        void filterButton(const bool isOn, const InputBtn btn) {
-            uint8_t btnFilter = static_cast<uint8_t>(buttonsState[btn] >> 1u) & INPUT_FILTER_MASK;
-            bool edge = false;
-            filter(isOn, btnFilter, edge);
-            buttonsState[btn] = static_cast<uint8_t>(btnFilter << 1u) | edge;
+        // state flips after 2 matching polls in a row,
+        // polls are 16 ms system ticks, plus at most one input wake in between
+        VerticalDebouncer<1> buttons;
+
+        inline __attribute__((always_inline))
+        uint8_t buttonMask(const InputBtn btn) {
+            return buttonsPins::registerBits(BIT_MASK(btn));
         }
     }
 
@@ -322,36 +1919,50 @@ namespace UIDriver {
 
     inline __attribute__((always_inline))
     void pollInputs() {
-        pinMode::inputPrime();
-        pinMinus::inputPrime();
-        pinClick::inputPrime();
-        pinPlus::inputPrime();
+        // priming and LEDs change the pins as well
+        SystemTick::disarmInputWake();
+        // same as inputPrime() on every pin
+        buttonsPins::clearAll();
         ComboPinWaitInputSettle();
-        filterButton(pinMode::inputRead(), InputBtnMode);
-        filterButton(pinMinus::inputRead(), InputBtnMinus);
-        filterButton(pinClick::inputRead(), InputBtnClick);
-        filterButton(pinPlus::inputRead(), InputBtnPlus);
+        // pushed button pulls its pin low
+        buttons.update(~buttonsPins::read() & buttonsPins::mask);
+    }
+
+    // only pins with LED off can see a push, the rest wait for the next tick
+    inline __attribute__((always_inline))
+    void armInputWake() {
+        SystemTick::armInputWake(buttonsPins::mask);
     }
 
     inline __attribute__((always_inline))
     bool isRisingEdge(const InputBtn btn) {
-        return (buttonsState[btn] & 0b1u);
+        return buttons.risingEdges() & buttonMask(btn);
+    }
+
+    inline __attribute__((always_inline))
+    uint8_t risingEdges() {
+        return buttonsPins::groupBits(buttons.risingEdges());
+    }
+
+    inline __attribute__((always_inline))
+    bool isFallingEdge(const InputBtn btn) {
+        return buttons.fallingEdges() & buttonMask(btn);
+    }
+
+    inline __attribute__((always_inline))
+    bool isHeld(const InputBtn btn) {
+        return buttons.held() & buttonMask(btn);
     }
 
     inline __attribute__((always_inline))
     void setLEDs(const bool i3, const bool i2, const bool i1, const bool i0) {
-        pinMode::outputSet(i3);
-        pinMinus::outputSet(i2);
-        pinClick::outputSet(i1);
-        pinPlus::outputSet(i0);
+        buttonsPins::set((i3 << 3u) | (i2 << 2u) | (i1 << 1u) | i0);
     }
 
     inline __attribute__((always_inline))
     void setLEDs(const uint8_t val) {
-        pinMode::outputSet(val & 0b1000u);
-        pinMinus::outputSet(val & 0b0100u);
-        pinClick::outputSet(val & 0b0010u);
-        pinPlus::outputSet(val & 0b0001u);
+        // all LEDs switch at once, no intermediate states
+        buttonsPins::set(val);
     }
 }
 
@@ -359,196 +1970,389 @@ namespace UIDriver {
 
 // -------- NOTES SEQUENCES --------
 
-namespace ActiveNoteNotesSequence {
-    namespace {
-        uint8_t activeNoteIndex = 0;
+// every logic is a Sequencer put together from policies:
+// - NoteSource: note index to play next, from the note the buttons set (the LEDs show it too),
+//   how many subdivisions it lasts, and moving on to the one after it once it has started
+// - WaveSource: waveform index to play the note with
+// - BendPolicy: bend to play the note with
+// - ButtonMap: what each button does to the note, waveform, bend and tempo the sequencer keeps
+// - SecondVoice: note the second voice plays along, when the engine has one, silent unless the logic picks one
+// policies are resolved at compile time, a logic costs only the code of the policies it uses
+//
+// everything runs in the main loop: the generator asks for the next note a note ahead and again after a press,
+// so a note never mixes settings of before and after a press, and no state is shared with interrupts
+namespace Sequencing {
+    // down and up of each setting, in Settings order
+    enum Action {
+        NoteDown,
+        NoteUp,
+        WaveDown,
+        WaveUp,
+        BendDown,
+        BendUp,
+        TempoDown,
+        TempoUp,
+    };
+
+    template<Action mode, Action minus, Action click, Action plus>
+    struct ButtonMap {
+        static const Action MODE = mode;
+
+        static const Action MINUS = minus;
 
-        uint8_t  activeWaveformIndex = 0;
+        static const Action CLICK = click;
 
-        uint8_t bend = 0;
+        static const Action PLUS = plus;
+    };
+
+    struct Settings {
+        uint8_t note;
+
+        uint8_t waveform;
+
+        uint8_t bend;
+
+        // index in TEMPOS_BPM, 0 is the beat of 1/8 s
+        uint8_t tempo;
+    };
+
+    namespace {
+        // one for all the logics, ModeSwitch carries the settings over to the next logic
+        Settings settings = {};
     }
 
-    class Logic {
-    public:
+    // steps the setting the action is for, a compile time action folds into one increment or decrement
+    inline __attribute__((always_inline))
+    void apply(const Action action) {
+        uint8_t& setting = reinterpret_cast<uint8_t*>(&settings)[static_cast<uint8_t>(action) >> 1u];
+        setting += static_cast<uint8_t>(((action & 0b1u) << 1u) - 1u);
+    }
+
+    // note set by the buttons
+    struct HeldNote {
+        // how far advance() moves the note on, ModeSwitch plays held and stepping notes by it
+        static const uint8_t STEP = 0;
+
         inline __attribute__((always_inline))
         static void init() {
         }
 
         inline __attribute__((always_inline))
-        static void onCycle() {
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMode)) {
-                bend--;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMinus)) {
-                activeNoteIndex++;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnClick)) {
-                bend++;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnPlus)) {
-                activeWaveformIndex++;
-            }
-            UIDriver::setLEDs(activeNoteIndex);
+        static uint8_t note(const uint8_t note) {
+            return note;
         }
 
         inline __attribute__((always_inline))
-        static WaveformGen::NoteInfo nextNote() {
-            const uint8_t noteDivisions = readNoteDivisions(activeNoteIndex);
-            const uint8_t noteWaveform = readWaveform(activeWaveformIndex);
-            return WaveformGen::NoteInfo { noteDivisions, noteWaveform, bend };
+        static uint8_t duration() {
+            return SUBDIVISIONS_PER_BEAT;
+        }
+
+        inline __attribute__((always_inline))
+        static void advance() {
         }
     };
-}
 
-namespace AutoNotesSequence {
-    namespace {
-        uint8_t activeNoteIndex = 0;
+    // steps through the notes, one per beat, starting from the note set by the buttons:
+    // the note setting itself moves on, the LEDs follow it and ModeSwitch goes on from it
+    struct AutoNote {
+        static const uint8_t STEP = 1u;
+
+        inline __attribute__((always_inline))
+        static void init() {
+        }
 
-        uint8_t  activeWaveformIndex = 0;
+        inline __attribute__((always_inline))
+        static uint8_t note(const uint8_t note) {
+            return note;
+        }
 
-        uint8_t bend = 0;
-    }
+        inline __attribute__((always_inline))
+        static uint8_t duration() {
+            return SUBDIVISIONS_PER_BEAT;
+        }
 
-    class Logic {
+        inline __attribute__((always_inline))
+        static void advance() {
+            settings.note += STEP;
+        }
+    };
+
+    struct HeldWave {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t noteIndex, const uint8_t waveform) {
+            return waveform;
+        }
+    };
+
+    // note index 0 is a rest
+    struct RestAwareWave {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t noteIndex, const uint8_t waveform) {
+            return noteIndex > 0 ? waveform : 0;
+        }
+    };
+
+    struct HeldBend {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t bend) {
+            return bend;
+        }
+    };
+
+    // no second voice, a logic plays one unless it asks for it
+    struct SilentSecond {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t noteIndex) {
+            return 0;
+        }
+    };
+
+    // second voice two note indices under the note, a third in the notes table of text songs,
+    // silent under the lowest two notes and rests
+    struct ThirdBelow {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t noteIndex) {
+            const uint8_t note = ConstDiv<NOTES_COUNT>::mod(noteIndex);
+            return note > 2u ? static_cast<uint8_t>(note - 2u) : 0;
+        }
+    };
+
+    // notes a logic plays, buttons aside
+    template<typename NoteSource, typename WaveSource, typename BendPolicy, typename SecondVoice = SilentSecond>
+    class NoteSequence {
     public:
+        typedef NoteSource Notes;
+
         inline __attribute__((always_inline))
         static void init() {
+            NoteSource::init();
+        }
+
+        // the same note until advance()
+        inline __attribute__((always_inline))
+        static WaveformGen::NoteInfo nextNote() {
+            const uint8_t noteIndex = NoteSource::note(settings.note);
+            return WaveformGen::NoteInfo {
+                    noteIndex, WaveSource::next(noteIndex, settings.waveform), BendPolicy::next(settings.bend),
+                    NoteSource::duration(), settings.tempo,
+                    static_cast<uint8_t>(WaveformGen::VOICES_COUNT > 1u ? SecondVoice::next(noteIndex) : 0u) };
+        }
+
+        inline __attribute__((always_inline))
+        static void advance() {
+            NoteSource::advance();
         }
+    };
+
+    template<typename NoteSource, typename WaveSource, typename BendPolicy, typename Buttons,
+             typename SecondVoice = SilentSecond>
+    class Sequencer : public NoteSequence<NoteSource, WaveSource, BendPolicy, SecondVoice> {
+    public:
+        typedef Buttons ButtonActions;
 
+        // true when a press has changed the settings
         inline __attribute__((always_inline))
-        static void onCycle() {
+        static bool onCycle(const bool) {
+            bool isChanged = false;
             if (UIDriver::isRisingEdge(UIDriver::InputBtnMode)) {
-                bend--;
+                apply(Buttons::MODE);
+                isChanged = true;
             }
             if (UIDriver::isRisingEdge(UIDriver::InputBtnMinus)) {
-                activeWaveformIndex--;
+                apply(Buttons::MINUS);
+                isChanged = true;
             }
             if (UIDriver::isRisingEdge(UIDriver::InputBtnClick)) {
-                bend++;
+                apply(Buttons::CLICK);
+                isChanged = true;
             }
             if (UIDriver::isRisingEdge(UIDriver::InputBtnPlus)) {
-                activeWaveformIndex++;
+                apply(Buttons::PLUS);
+                isChanged = true;
             }
-            UIDriver::setLEDs(activeNoteIndex);
+            UIDriver::setLEDs(NoteSource::note(settings.note));
+            return isChanged;
+        }
+    };
+}
+
+namespace ActiveNoteNotesSequence {
+    using namespace Sequencing;
+
+    typedef Sequencer<HeldNote, HeldWave, HeldBend, ButtonMap<BendDown, NoteUp, BendUp, WaveUp>> Logic;
+}
+
+namespace AutoNotesSequence {
+    using namespace Sequencing;
+
+    typedef Sequencer<AutoNote, HeldWave, HeldBend, ButtonMap<BendDown, WaveDown, BendUp, WaveUp>> Logic;
+}
+
+namespace FlashMemoryMelody {
+    namespace {
+        // patterns of note indices in NOTES_FREQUENCIES array, one per beat, 0 is a rest,
+        // arranged with repeats and transposes, see res/songs/sample.song
+        SongStream<SampleSong::Song> songStream;
+    }
+
+    // plays the song, buttons do not pick notes, LEDs show the note coming next
+    struct MelodyNote {
+        inline __attribute__((always_inline))
+        static void init() {
+            songStream.next();
         }
 
         inline __attribute__((always_inline))
-        static WaveformGen::NoteInfo nextNote() {
-            const uint8_t noteDivisions = readNoteDivisions(activeNoteIndex++);
-            const uint8_t noteWaveform = readWaveform(activeWaveformIndex);
-            return WaveformGen::NoteInfo { noteDivisions, noteWaveform, bend };
+        static uint8_t note(const uint8_t note) {
+            return songStream.last();
+        }
+
+        // a run of beats of one note plays as a single note
+        inline __attribute__((always_inline))
+        static uint8_t duration() {
+            return songStream.beats() * SUBDIVISIONS_PER_BEAT;
+        }
+
+        inline __attribute__((always_inline))
+        static void advance() {
+            songStream.next();
+        }
+    };
+
+    using namespace Sequencing;
+
+    // drums of the song play as noise whatever the waveform (rests without -DNOISE), a song without drums never checks
+    struct SongWave {
+        inline __attribute__((always_inline))
+        static uint8_t next(const uint8_t noteIndex, const uint8_t waveform) {
+            const uint8_t lastNoiseNote = SampleSong::Song::LAST_NOISE_NOTE;
+            if (0 != lastNoiseNote && 0 != noteIndex && noteIndex <= lastNoiseNote) {
+#ifdef NOISE
+                return NOISE_WAVEFORM;
+#else
+                return 0;
+#endif
+            }
+            return RestAwareWave::next(noteIndex, waveform);
         }
     };
+
+    // Mode and Click were the bend buttons, the song now plays at the bend it starts with and they set the tempo;
+    // DUO plays a third under the song
+    typedef Sequencer<MelodyNote, SongWave, HeldBend, ButtonMap<TempoDown, WaveDown, TempoUp, WaveUp>, ThirdBelow> Logic;
 }
 
-namespace FlashMemoryMelody {
-    namespace {
-        const uint8_t _SAMPLE_MELODY_0_POINTS[] PROGMEM = {
-            0xAA, 0x0A, 0x08, 0xA0,
-            0xC0, 0x00, 0x50, 0x00,
-            0x80, 0x05, 0x00, 0x30,
-            0x06, 0x07, 0x06, 0x60,
+namespace Fooz {
+    using namespace Sequencing;
 
-            0x00, 0x00, 0x00, 0x00,
-        };
+    typedef Sequencer<HeldNote, HeldWave, HeldBend, ButtonMap<BendUp, NoteDown, WaveUp, NoteUp>> Logic;
+}
 
-        const uint8_t _SAMPLE_MELODY_0_POINTS_COUNT = sizeof(_SAMPLE_MELODY_0_POINTS) / sizeof(uint8_t);
+// the logics that pick notes with the buttons in one image, holding Mode for half a second switches to the next one;
+// FlashMemoryMelody is left out, its song stream and song take about as much flash as the other three
+// (the push itself still does what Mode does in the logic being left)
+// the logics differ only in what their buttons do and in how far their notes step, which is all a flash table
+// keeps of them: one button handler and one note sequence play them all, sram only keeps where the row is
+namespace ModeSwitch {
+    // a row of the flash table
+    struct ModeData {
+        // in UIDriver::InputBtn order
+        uint8_t actions[UIDriver::InputButtonsCount];
+
+        uint8_t noteStep;
+    };
 
-        // one point is two 4-bit notes indices in NOTES_DIVISIONS array
-        const uint8_t _SAMPLE_MELODY_0_NOTES_COUNT = _SAMPLE_MELODY_0_POINTS_COUNT * 2;
+    // logics playing the held waveform and bend, one beat per note, see SwitchedNote
+    template<typename... ModeLogics>
+    struct ModesData {
+        ModeData modes[sizeof...(ModeLogics)];
 
-        uint8_t readMelodyPoint(const uint8_t pointIndex) {
-            divv::div(pointIndex, _SAMPLE_MELODY_0_POINTS_COUNT);
-            const uint8_t indexMod = divv::remainder;
-            return pgm_read_byte(&(_SAMPLE_MELODY_0_POINTS[indexMod]));
+        constexpr ModesData()
+                : modes { { { ModeLogics::ButtonActions::PLUS, ModeLogics::ButtonActions::CLICK,
+                              ModeLogics::ButtonActions::MINUS, ModeLogics::ButtonActions::MODE },
+                            ModeLogics::Notes::STEP }... } {
         }
-    }
+    };
 
     namespace {
-        uint8_t melodyNoteIndex = 0;
+        const ModesData<Fooz::Logic, AutoNotesSequence::Logic, ActiveNoteNotesSequence::Logic> MODES PROGMEM;
 
-        uint8_t lastNoteDivisionsIndex = 0;
+        const uint8_t LAST_MODE_OFFSET = sizeof(MODES.modes) - sizeof(ModeData);
 
-        uint8_t activeWaveformIndex = 0;
+        // counted in 16 ms system ticks only, input wakes come at any rate while a button bounces;
+        // heldTicks wraps, so a Mode held on switches again every 256 ticks
+        const uint8_t LONG_PRESS_TICKS = 32u;
 
-        uint8_t bend = false;
+        // of the mode's row in MODES, kept in bytes so no index is multiplied
+        uint8_t modeOffset = 0;
+
+        uint8_t heldTicks = 0;
+
+        inline __attribute__((always_inline))
+        const ModeData& mode() {
+            return *reinterpret_cast<const ModeData*>(reinterpret_cast<const uint8_t*>(MODES.modes) + modeOffset);
+        }
     }
 
-    class Logic {
-    public:
+    // held or stepping note, as the logic switched to has it
+    struct SwitchedNote {
         inline __attribute__((always_inline))
         static void init() {
         }
 
         inline __attribute__((always_inline))
-        static void onCycle() {
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMode)) {
-                bend--;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMinus)) {
-                activeWaveformIndex--;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnClick)) {
-                bend++;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnPlus)) {
-                activeWaveformIndex++;
-            }
-            UIDriver::setLEDs(lastNoteDivisionsIndex);
+        static uint8_t note(const uint8_t note) {
+            return note;
         }
 
         inline __attribute__((always_inline))
-        static WaveformGen::NoteInfo nextNote() {
-            uint8_t point = readMelodyPoint(melodyNoteIndex / 2);
-            if (0 == melodyNoteIndex % 2) {
-                point = __builtin_avr_swap(point);
-            }
-            lastNoteDivisionsIndex = point & 0b1111u;
-            melodyNoteIndex++; // funny thing, moving this line up or down increases code size
-            const uint8_t noteDivisions = readNoteDivisions(lastNoteDivisionsIndex);
-            const uint8_t noteWaveform = lastNoteDivisionsIndex > 0 ? readWaveform(activeWaveformIndex) : 0;
-            return WaveformGen::NoteInfo { noteDivisions, noteWaveform, bend };
+        static uint8_t duration() {
+            return SUBDIVISIONS_PER_BEAT;
         }
-    };
-}
-
-namespace Fooz {
-    namespace {
-        uint8_t activeNoteIndex = 0;
 
-        uint8_t activeWaveformIndex = 0;
+        inline __attribute__((always_inline))
+        static void advance() {
+            Sequencing::settings.note += pgm_read_byte(&(mode().noteStep));
+        }
+    };
 
-        uint8_t bend = 0;
-    }
+    typedef Sequencing::NoteSequence<SwitchedNote, Sequencing::HeldWave, Sequencing::HeldBend> Notes;
 
     class Logic {
     public:
         inline __attribute__((always_inline))
         static void init() {
+            Notes::init();
         }
 
+        // a switch only changes how far the notes step from the next advance on, the prepared note stays
         inline __attribute__((always_inline))
-        static void onCycle() {
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMode)) {
-                bend++;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnMinus)) {
-                activeNoteIndex--;
+        static bool onCycle(const bool isTick) {
+            if (!UIDriver::isHeld(UIDriver::InputBtnMode)) {
+                heldTicks = 0;
+            } else if (isTick && LONG_PRESS_TICKS == ++heldTicks) {
+                modeOffset = LAST_MODE_OFFSET == modeOffset ? 0 : modeOffset + sizeof(ModeData);
             }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnClick)) {
-                activeWaveformIndex++;
-            }
-            if (UIDriver::isRisingEdge(UIDriver::InputBtnPlus)) {
-                activeNoteIndex++;
+            uint8_t edges = UIDriver::risingEdges();
+            const bool isChanged = 0 != edges;
+            const uint8_t* action = mode().actions;
+            for (uint8_t button = 0; button < UIDriver::InputButtonsCount; button++, edges >>= 1u, action++) {
+                if (edges & 0b1u) {
+                    Sequencing::apply(static_cast<Sequencing::Action>(pgm_read_byte(action)));
+                }
             }
-            UIDriver::setLEDs(activeNoteIndex);
+            UIDriver::setLEDs(SwitchedNote::note(Sequencing::settings.note));
+            return isChanged;
         }
 
         inline __attribute__((always_inline))
         static WaveformGen::NoteInfo nextNote() {
-            const uint8_t noteDivisions = readNoteDivisions(activeNoteIndex);
-            const uint8_t noteWaveform = readWaveform(activeWaveformIndex);
-            return WaveformGen::NoteInfo { noteDivisions, noteWaveform, bend };
+            return Notes::nextNote();
+        }
+
+        inline __attribute__((always_inline))
+        static void advance() {
+            Notes::advance();
         }
     };
 }
@@ -565,7 +2369,7 @@ namespace MainProtos {
         }
 
         inline __attribute__((always_inline))
-        static void onCycle() {
+        static bool onCycle(const bool) {
             if (UIDriver::isRisingEdge(UIDriver::InputBtnMode)) {
             }
             if (UIDriver::isRisingEdge(UIDriver::InputBtnMinus)) {
@@ -575,26 +2379,36 @@ namespace MainProtos {
             if (UIDriver::isRisingEdge(UIDriver::InputBtnPlus)) {
             }
             UIDriver::setLEDs(true, false, true, false);
+            return false;
         }
 
         static WaveformGen::NoteInfo nextNote() {
-            return WaveformGen::NoteInfo { 0, 0 };
+            return WaveformGen::NoteInfo { 0, 0, 0, SUBDIVISIONS_PER_BEAT, 0, 0 };
+        }
+
+        inline __attribute__((always_inline))
+        static void advance() {
         }
     };
 }
 
-typedef Fooz::Logic MainLogic;
+typedef MAIN_LOGIC MainLogic;
 
 WaveformGen::NoteInfo WaveformGen::nextNoteSource() {
     return MainLogic::nextNote();
 }
 
+void WaveformGen::advanceNoteSource() {
+    MainLogic::advance();
+}
+
 class Main {
 public:
     inline __attribute__((always_inline))
     static void init() {
         UIDriver::init();
         MainLogic::init();
+        SystemTick::init();
         WaveformGen::restartGenerator();
     }
 
@@ -611,10 +2425,24 @@ public:
 private:
     inline __attribute__((always_inline))
     static void cycle() {
+        const bool isTick = SystemTick::wait();
+        if (isTick) {
+            WaveformGen::onMainLoopTick();
+        }
         UIDriver::pollInputs();
-        MainLogic::onCycle();
-        fixedDelayLong();
-        fixedDelayLong();
+        // the logic is told whether a tick woke the loop, for timing things in ticks
+        if (MainLogic::onCycle(isTick)) {
+            WaveformGen::onNoteSourceChanged();
+        }
+        // input wake stays off until the next tick, so a bouncing button is sampled at most twice per tick
+        if (isTick) {
+            UIDriver::armInputWake();
+        }
+#ifdef STACK_PAINT
+        if (isTick && StackPaint::track()) {
+            eeprom_update_byte(reinterpret_cast<uint8_t*>(STACK_HIGH_WATER_EEPROM_ADDRESS), StackPaint::highWater);
+        }
+#endif
     }
 };
 
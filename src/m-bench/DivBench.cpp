@@ -0,0 +1,120 @@
+
+#include "../m-toolbox/Macro.h"
+#include "../m-toolbox/ConstDiv.h"
+
+#include <avr/eeprom.h>
+
+// -------- DIVISION BENCHMARK --------
+
+// cycle counts of ConstDiv against repeated subtraction divv::div it replaced in main.cpp,
+// for every 8-bit dividend and every constant divisor used by the app
+//
+// Timer0 runs from the cpu clock without prescaler, each operation is a noinline call
+// timed with TCNT0 (+256 on overflow), the cost of an empty call is subtracted
+//
+// results go to eeprom, read them with `make div_bench_read`
+// layout, per divisor in main() order, little endian uint16_t:
+//   { divisor, legacy min, legacy max, const min, const max }
+
+namespace divv {
+    uint8_t remainder;
+
+    uint8_t div(uint8_t dividend, const uint8_t divisor) {
+        uint8_t result = 0;
+        while (dividend >= divisor) {
+            dividend -= divisor;
+            result++;
+        }
+        remainder = dividend;
+        return result;
+    }
+}
+
+namespace {
+    struct BenchResult {
+        uint16_t divisor;
+
+        uint16_t legacyMin;
+
+        uint16_t legacyMax;
+
+        uint16_t constMin;
+
+        uint16_t constMax;
+    };
+
+    volatile uint8_t sink;
+
+    __attribute__((noinline))
+    void opEmpty(const uint8_t dividend, const uint8_t) {
+        sink = dividend;
+    }
+
+    __attribute__((noinline))
+    void opLegacy(const uint8_t dividend, const uint8_t divisor) {
+        sink = divv::div(dividend, divisor);
+        sink = divv::remainder;
+    }
+
+    template <uint8_t Divisor>
+    __attribute__((noinline))
+    void opConst(const uint8_t dividend, const uint8_t) {
+        sink = ConstDiv<Divisor>::div(dividend);
+        sink = ConstDiv<Divisor>::mod(dividend);
+    }
+
+    typedef void (*BenchOp)(uint8_t dividend, uint8_t divisor);
+
+    __attribute__((noinline))
+    uint16_t measure(const BenchOp op, const uint8_t dividend, const uint8_t divisor) {
+        ACCESS_BYTE(TCNT0) = 0;
+        ACCESS_BYTE(TIFR0) = BIT_MASK(TOV0);
+        op(dividend, divisor);
+        const uint8_t count = ACCESS_BYTE(TCNT0);
+        const bool overflow = IS_BYTE_BIT_SET(TIFR0, TOV0);
+        // overflow right after reading the counter shows up as a large count with the flag set
+        return (overflow && count < 0x80u) ? count + 256u : count;
+    }
+
+    void measureRange(const BenchOp op, const uint8_t divisor, const uint16_t overhead,
+                      uint16_t& minCycles, uint16_t& maxCycles) {
+        minCycles = UINT16_MAX;
+        maxCycles = 0;
+        uint8_t dividend = 0;
+        do {
+            const uint16_t cycles = measure(op, dividend, divisor) - overhead;
+            minCycles = cycles < minCycles ? cycles : minCycles;
+            maxCycles = cycles > maxCycles ? cycles : maxCycles;
+        } while (0 != ++dividend);
+    }
+
+    template <uint8_t Divisor>
+    void benchDivisor(const uint8_t slot, const uint16_t overhead) {
+        BenchResult result;
+        result.divisor = Divisor;
+        measureRange(&opLegacy, Divisor, overhead, result.legacyMin, result.legacyMax);
+        measureRange(&opConst<Divisor>, Divisor, overhead, result.constMin, result.constMax);
+        eeprom_update_block(&result, reinterpret_cast<void*>(slot * sizeof(BenchResult)), sizeof(BenchResult));
+    }
+}
+
+int main() {
+    // no pre-scaler, normal mode
+    ACCESS_BYTE(TCCR0B) = BIT_MASK(CS00);
+
+    uint16_t overhead = 0;
+    uint16_t overheadMax = 0;
+    measureRange(&opEmpty, 1, 0, overhead, overheadMax);
+
+    // NOTES_COUNT, WAVEFORMS_COUNT, WAVEFORM_LENGTH + 1, _SAMPLE_MELODY_0_POINTS_COUNT
+    benchDivisor<16>(0, overhead);
+    benchDivisor<4>(1, overhead);
+    benchDivisor<9>(2, overhead);
+    benchDivisor<20>(3, overhead);
+
+    while (true) {
+    }
+    return 0;
+}
+
+// ----------------
@@ -0,0 +1,147 @@
+#include "../m-toolbox/Macro.h"
+#include "../m-toolbox/Glide.h"
+
+#include <avr/eeprom.h>
+
+// -------- GLIDE BENCHMARK --------
+
+// cycle counts of a Glide step, with the value ranges of the CTC engine (8.8 fixed point segment ticks)
+// and the DDS engine (phase steps), over a whole slide of two octaves up and down and a whole sweep
+// until it saturates, and of the isMoving() check a settled glide costs per wave period
+//
+// Timer0 runs from the cpu clock without prescaler, each operation is a noinline call
+// timed with TCNT0 (+256 on overflow), the cost of an empty call is subtracted
+//
+// results go to eeprom, read them with `make glide_bench_read`
+// layout, per case in main() order, little endian uint16_t:
+//   { case, steps, min, max }
+
+namespace {
+    // C6 and C8, segment ticks at pre-scaler 8 and phase steps at 256 cycles a sample
+    const uint16_t SEGMENT_TIME_LOW = 32617u;
+
+    const uint16_t SEGMENT_TIME_HIGH = 8154u;
+
+    const uint16_t PHASE_STEP_LOW = 1829u;
+
+    const uint16_t PHASE_STEP_HIGH = 7316u;
+
+    typedef Glide<(15u + 1u) << 8u, 0xFFFFu, true> SegmentGlide;
+
+    typedef Glide<37u, PHASE_STEP_HIGH, false> PhaseStepGlide;
+
+    struct BenchResult {
+        uint16_t id;
+
+        uint16_t steps;
+
+        uint16_t minCycles;
+
+        uint16_t maxCycles;
+    };
+
+    volatile uint8_t sink;
+
+    SegmentGlide segmentGlide;
+
+    PhaseStepGlide phaseStepGlide;
+
+    __attribute__((noinline))
+    void opEmpty() {
+        sink = 0;
+    }
+
+    __attribute__((noinline))
+    void opSegmentStep() {
+        segmentGlide.step();
+    }
+
+    __attribute__((noinline))
+    void opPhaseStep() {
+        phaseStepGlide.step();
+    }
+
+    __attribute__((noinline))
+    void opSettled() {
+        sink = segmentGlide.isMoving();
+    }
+
+    typedef void (*BenchOp)();
+
+    __attribute__((noinline))
+    uint16_t measure(const BenchOp op) {
+        ACCESS_BYTE(TCNT0) = 0;
+        ACCESS_BYTE(TIFR0) = BIT_MASK(TOV0);
+        op();
+        const uint8_t count = ACCESS_BYTE(TCNT0);
+        const bool overflow = IS_BYTE_BIT_SET(TIFR0, TOV0);
+        // overflow right after reading the counter shows up as a large count with the flag set
+        return (overflow && count < 0x80u) ? count + 256u : count;
+    }
+
+    // steps until the glide settles, a sweep never does and is cut at 255 steps
+    template<typename G>
+    void measureGlide(G& glide, const BenchOp op, const uint16_t overhead, BenchResult& result) {
+        result.steps = 0;
+        result.minCycles = UINT16_MAX;
+        result.maxCycles = 0;
+        while (glide.isMoving() && result.steps < 255u) {
+            const uint16_t cycles = measure(op) - overhead;
+            result.minCycles = cycles < result.minCycles ? cycles : result.minCycles;
+            result.maxCycles = cycles > result.maxCycles ? cycles : result.maxCycles;
+            result.steps++;
+        }
+    }
+
+    void store(const uint8_t slot, const BenchResult& result) {
+        eeprom_update_block(&result, reinterpret_cast<void*>(slot * sizeof(BenchResult)), sizeof(BenchResult));
+    }
+
+    // slides from one note to another, then sweeps from the second one
+    template<typename G>
+    void benchGlide(G& glide, const BenchOp op, const uint8_t slot, const uint16_t from, const uint16_t to,
+                    const uint8_t sweep, const uint16_t overhead) {
+        BenchResult result;
+        glide.start(from, 0, false);
+        glide.start(to, GlideDetails::SLIDE, true);
+        result.id = slot;
+        measureGlide(glide, op, overhead, result);
+        store(slot, result);
+
+        glide.start(to, sweep, false);
+        result.id = slot + 1u;
+        measureGlide(glide, op, overhead, result);
+        store(slot + 1u, result);
+    }
+}
+
+int main() {
+    // no pre-scaler, normal mode
+    ACCESS_BYTE(TCCR0B) = BIT_MASK(CS00);
+
+    uint16_t overhead = UINT16_MAX;
+    for (uint8_t i = 0; i < 16u; i++) {
+        const uint16_t cycles = measure(&opEmpty);
+        overhead = cycles < overhead ? cycles : overhead;
+    }
+
+    // slide up two octaves, then sweep of +1 down to the lowest pitch
+    benchGlide(segmentGlide, &opSegmentStep, 0, SEGMENT_TIME_LOW, SEGMENT_TIME_HIGH, 0b01u, overhead);
+    // slide down two octaves, then sweep of -2 up to the highest pitch
+    benchGlide(phaseStepGlide, &opPhaseStep, 2, PHASE_STEP_HIGH, PHASE_STEP_LOW, 0b10u, overhead);
+
+    // what a wave period pays once the glide has settled
+    BenchResult settled;
+    segmentGlide.start(SEGMENT_TIME_LOW, 0, false);
+    settled.id = 4;
+    settled.steps = 1;
+    settled.minCycles = measure(&opSettled) - overhead;
+    settled.maxCycles = settled.minCycles;
+    store(4, settled);
+
+    while (true) {
+    }
+    return 0;
+}
+
+// ----------------
@@ -43,6 +43,13 @@ private:
     ComboPin() = default;
 
 public:
+    // for PinGroup, set state is output (LED on)
+    static const uint8_t groupStateRegister = DDRegister;
+
+    static const uint8_t groupInputRegister = PINRegister;
+
+    static const uint8_t groupMask = BIT_MASK(PinBit);
+
     inline __attribute__((always_inline))
     static void init() {
         setAsInput();
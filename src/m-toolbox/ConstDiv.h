@@ -0,0 +1,151 @@
+#ifndef MTBX_CONST_DIV_H
+#define MTBX_CONST_DIV_H
+
+#include <stdint.h>
+
+// 8-bit division and modulo by a compile-time constant divisor,
+// time does not depend on the quotient (unlike repeated subtraction)
+// implementation is picked per divisor:
+// - power of two: shift / mask
+// - micros with hardware multiplier: reciprocal multiply, when an exact 8-bit reciprocal exists
+// - everything else: unrolled restoring division, one compare-and-subtract per possible quotient bit,
+//   so dividing by 9 takes 5 steps and by 20 only 4
+
+namespace ConstDivDetails {
+    constexpr bool isPowerOfTwo(const uint8_t value) {
+        return 0 != value && 0 == (value & (value - 1u));
+    }
+
+    constexpr uint8_t log2(const uint8_t value) {
+        return value <= 1u ? 0u : 1u + log2(value >> 1u);
+    }
+
+    // highest shift of divisor that still fits into 8 bits
+    constexpr uint8_t topStep(const uint8_t divisor) {
+        return divisor > 0x7Fu ? 0u : 1u + topStep(static_cast<uint8_t>(divisor << 1u));
+    }
+
+    constexpr bool isExactReciprocal(const uint8_t divisor, const uint16_t multiplier, const uint8_t shift) {
+        for (uint16_t dividend = 0; dividend <= 0xFFu; dividend++) {
+            if ((dividend * multiplier) >> shift != dividend / divisor) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // smallest shift (>= 8) for which ceil(2^shift / divisor) fits into 8 bits and is exact, 0 if none
+    constexpr uint8_t reciprocalShift(const uint8_t divisor) {
+        for (uint8_t shift = 8; shift < 16; shift++) {
+            const uint16_t multiplier = static_cast<uint16_t>(((1ul << shift) + divisor - 1u) / divisor);
+            if (multiplier <= 0xFFu && isExactReciprocal(divisor, multiplier, shift)) {
+                return shift;
+            }
+        }
+        return 0;
+    }
+
+    constexpr uint8_t reciprocalMultiplier(const uint8_t divisor) {
+        return static_cast<uint8_t>(((1ul << reciprocalShift(divisor)) + divisor - 1u) / divisor);
+    }
+
+    enum Strategy {
+        StrategyShift,
+        StrategyReciprocal,
+        StrategyRestoring,
+    };
+
+    constexpr Strategy strategyFor(const uint8_t divisor) {
+#ifdef __AVR_HAVE_MUL__
+        return isPowerOfTwo(divisor) ? StrategyShift
+             : (0 != reciprocalShift(divisor) ? StrategyReciprocal : StrategyRestoring);
+#else
+        return isPowerOfTwo(divisor) ? StrategyShift : StrategyRestoring;
+#endif
+    }
+
+    template <uint8_t Divisor, uint8_t Step>
+    struct RestoringStep {
+        inline __attribute__((always_inline))
+        static void apply(uint8_t& remainder, uint8_t& quotient) {
+            const uint8_t shiftedDivisor = static_cast<uint8_t>(Divisor << Step);
+            if (remainder >= shiftedDivisor) {
+                remainder -= shiftedDivisor;
+                quotient |= static_cast<uint8_t>(1u << Step);
+            }
+            RestoringStep<Divisor, Step - 1>::apply(remainder, quotient);
+        }
+    };
+
+    template <uint8_t Divisor>
+    struct RestoringStep<Divisor, 0> {
+        inline __attribute__((always_inline))
+        static void apply(uint8_t& remainder, uint8_t& quotient) {
+            if (remainder >= Divisor) {
+                remainder -= Divisor;
+                quotient |= 1u;
+            }
+        }
+    };
+
+    template <uint8_t Divisor, Strategy S>
+    class Impl;
+
+    template <uint8_t Divisor>
+    class Impl<Divisor, StrategyShift> {
+    public:
+        inline __attribute__((always_inline))
+        static uint8_t div(const uint8_t dividend) {
+            return dividend >> log2(Divisor);
+        }
+
+        inline __attribute__((always_inline))
+        static uint8_t mod(const uint8_t dividend) {
+            return dividend & (Divisor - 1u);
+        }
+    };
+
+    template <uint8_t Divisor>
+    class Impl<Divisor, StrategyReciprocal> {
+    public:
+        inline __attribute__((always_inline))
+        static uint8_t div(const uint8_t dividend) {
+            const uint16_t product = static_cast<uint16_t>(dividend * reciprocalMultiplier(Divisor));
+            return static_cast<uint8_t>(product >> reciprocalShift(Divisor));
+        }
+
+        inline __attribute__((always_inline))
+        static uint8_t mod(const uint8_t dividend) {
+            return static_cast<uint8_t>(dividend - div(dividend) * Divisor);
+        }
+    };
+
+    template <uint8_t Divisor>
+    class Impl<Divisor, StrategyRestoring> {
+    public:
+        inline __attribute__((always_inline))
+        static uint8_t div(const uint8_t dividend) {
+            uint8_t remainder = dividend;
+            uint8_t quotient = 0;
+            RestoringStep<Divisor, topStep(Divisor)>::apply(remainder, quotient);
+            return quotient;
+        }
+
+        inline __attribute__((always_inline))
+        static uint8_t mod(const uint8_t dividend) {
+            uint8_t remainder = dividend;
+            uint8_t quotient = 0;
+            RestoringStep<Divisor, topStep(Divisor)>::apply(remainder, quotient);
+            return remainder;
+        }
+    };
+}
+
+template <uint8_t Divisor>
+class ConstDiv : public ConstDivDetails::Impl<Divisor, ConstDivDetails::strategyFor(Divisor)> {
+    static_assert(0 != Divisor, "division by zero");
+
+    ConstDiv() = default;
+};
+
+#endif // MTBX_CONST_DIV_H
@@ -0,0 +1,96 @@
+#ifndef MTBX_GLIDE_H
+#define MTBX_GLIDE_H
+
+#include <stdint.h>
+
+// pitch of the playing note as a 16-bit fixed point value, either a period (grows as the pitch falls)
+// or a phase step (grows with the pitch), moving towards a target by a fixed share of itself a step,
+// so with steps coming at a fixed rate a slide or a bend takes the same cents per second at any pitch
+//
+// bend byte of a note:
+// - bits 0..1: sweep, 2-bit two's complement, positive lowers the pitch, moves the target every step
+// - bit 2:     slide from the pitch of the note before instead of starting at the target
+// a sweep saturates at Lowest..Highest, a slide stays between the two notes it joins
+// a step costs a few shifts and compares, nothing runs at all once the value has settled
+
+namespace GlideDetails {
+    const uint8_t SWEEP_MASK = 0b11u;
+
+    const uint8_t SLIDE = 0b100u;
+
+    // sweep of -2 moves twice as fast
+    const uint8_t SWEEP_DOUBLE = 0b10u;
+
+    // share of the value a slide step takes, 1/32, ~54 cents
+    const uint8_t SLIDE_SHIFT = 5u;
+
+    inline __attribute__((always_inline))
+    uint8_t highByte(const uint16_t value) {
+        return static_cast<uint8_t>(value >> 8u);
+    }
+}
+
+template<uint16_t Lowest, uint16_t Highest, bool IsPeriod>
+class Glide {
+public:
+    // nothing to slide from before the first note, or when the caller says so
+    inline __attribute__((always_inline))
+    void start(const uint16_t target, const uint8_t bend, const bool canSlide) {
+        targetValue = target;
+        sweep = bend & GlideDetails::SWEEP_MASK;
+        if (!canSlide || 0 == (bend & GlideDetails::SLIDE) || 0 == currentValue) {
+            currentValue = target;
+        }
+    }
+
+    // a step would change nothing otherwise
+    inline __attribute__((always_inline))
+    bool isMoving() const {
+        return 0 != sweep || currentValue != targetValue;
+    }
+
+    inline __attribute__((always_inline))
+    void step() {
+        if (0 != sweep) {
+            moveTarget();
+        }
+        uint16_t delta = currentValue >> GlideDetails::SLIDE_SHIFT;
+        delta = 0 == delta ? 1u : delta;
+        if (currentValue < targetValue) {
+            currentValue = targetValue - currentValue > delta ? currentValue + delta : targetValue;
+        } else if (currentValue > targetValue) {
+            currentValue = currentValue - targetValue > delta ? currentValue - delta : targetValue;
+        }
+    }
+
+    inline __attribute__((always_inline))
+    uint16_t value() const {
+        return currentValue;
+    }
+
+private:
+    uint16_t currentValue = 0;
+
+    uint16_t targetValue = 0;
+
+    uint8_t sweep = 0;
+
+    // a sweep step takes twice the high byte of the target, 1/128, ~13.5 cents
+    inline __attribute__((always_inline))
+    void moveTarget() {
+        const uint8_t share = GlideDetails::highByte(targetValue);
+        uint16_t delta = static_cast<uint16_t>(0 == share ? 1u : share) << 1u;
+        if (GlideDetails::SWEEP_DOUBLE == sweep) {
+            delta <<= 1u;
+        }
+        // positive sweep lowers the pitch, which makes a period longer and a phase step smaller
+        const bool isPositive = 0 == (sweep & GlideDetails::SWEEP_DOUBLE);
+        if (isPositive == IsPeriod) {
+            targetValue = targetValue > Highest - delta ? Highest : targetValue + delta;
+        } else {
+            targetValue = targetValue < Lowest + delta ? Lowest : targetValue - delta;
+        }
+    }
+};
+
+#endif // MTBX_GLIDE_H
@@ -22,5 +22,8 @@
 #define SET_BYTE_BIT(ADDRESS, BIT)      (ACCESS_BYTE(ADDRESS) |= BIT_MASK(BIT))
 #define CLEAR_BYTE_BIT(ADDRESS, BIT)    (ACCESS_BYTE(ADDRESS) &= ~BIT_MASK(BIT))
 
+// the compiler keeps memory accesses on their side of it, data handed to an interrupt is written before the flag
+#define MEMORY_BARRIER()                __asm__ __volatile__("" ::: "memory")
+
 
 #endif // MTBX_MACRO_H
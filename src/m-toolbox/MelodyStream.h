@@ -0,0 +1,144 @@
+#ifndef MTBX_MELODY_STREAM_H
+#define MTBX_MELODY_STREAM_H
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+// melody packed into 4-bit codes in flash, high nibble of every byte first:
+// - 0..14: one beat of that note index, 0 is a rest
+// - 15 n:  n + 1 more beats of the note before
+// a beat never takes more than one code, so packing is at worst as large as a nibble per beat,
+// while a long note or rest takes 3 codes for up to 17 beats
+//
+// a song strings patterns together: every pattern is packed on its own (so it never starts with a repeat)
+// into one code stream, a song entry plays one of them a number of times, transposed by some note indices;
+// `ATTiny13SongPack` (tools/host/song) writes songs as headers for SongStream
+
+namespace MelodyStreamDetails {
+    const uint8_t REPEAT = 15u;
+
+    // a note and the 16 repeats one REPEAT code can stand for
+    const uint8_t MAX_RUN = 17u;
+
+    inline __attribute__((always_inline))
+    uint8_t readPosition(const uint8_t* const address) {
+        return pgm_read_byte(address);
+    }
+
+    inline __attribute__((always_inline))
+    uint16_t readPosition(const uint16_t* const address) {
+        return pgm_read_word(address);
+    }
+}
+
+// one line of a song, in flash
+struct SongEntry {
+    uint8_t pattern;
+
+    // plays of the pattern in a row, at least 1
+    uint8_t plays;
+
+    // added to every note index of the pattern, rests stay rests
+    int8_t transpose;
+};
+
+// Song is a generated header's struct (see ATTiny13SongPack):
+//   typedef uint8_t or uint16_t Position, holds every code index up to the codes count
+//   static const uint8_t ENTRIES_COUNT
+//   static const uint8_t LAST_NOISE_NOTE, note indices up to it are drums, 0 for none
+//   static const uint8_t* codes(), packed patterns one after another
+//   static const Position* patternStarts(), first code of every pattern plus the codes count
+//   static const SongEntry* entries()
+// the stream hands out notes rather than beats: a note and the REPEAT after it come as one note
+// lasting up to MAX_RUN beats, a longer run goes on as more notes of the same index;
+// a note still reads at most three codes, plus one entry and two pattern starts when a pattern ends,
+// the song restarts after its last entry
+template<typename Song>
+class SongStream {
+public:
+    // note index of the next note, beats() tells how long it lasts;
+    // a logic starts the stream and moves it on from two places, one copy of it is plenty
+    __attribute__((noinline))
+    uint8_t next() {
+        if (position == patternEnd) {
+            nextPattern();
+        }
+        const uint8_t code = read();
+        if (MelodyStreamDetails::REPEAT == code) {
+            // a run too long for the REPEAT after its note
+            runBeats = read() + 1u;
+            return lastBeat;
+        }
+        lastBeat = 0 == code ? 0 : static_cast<uint8_t>(code + transpose);
+        runBeats = 1;
+        // patterns are packed on their own, a REPEAT never repeats a note of the pattern before
+        if (position != patternEnd && MelodyStreamDetails::REPEAT == peek()) {
+            position++;
+            runBeats = read() + 2u;
+        }
+        return lastBeat;
+    }
+
+    // beats of the note next() returned last, 1..MAX_RUN
+    uint8_t beats() const {
+        return runBeats;
+    }
+
+    uint8_t last() const {
+        return lastBeat;
+    }
+
+private:
+    typedef typename Song::Position Position;
+
+    Position position = 0;
+
+    Position patternEnd = 0;
+
+    // next entry to play, null until the first one
+    const SongEntry* entry = nullptr;
+
+    uint8_t pattern = 0;
+
+    uint8_t playsLeft = 0;
+
+    int8_t transpose = 0;
+
+    uint8_t runBeats = 1;
+
+    uint8_t lastBeat = 0;
+
+    inline __attribute__((always_inline))
+    void nextPattern() {
+        if (0 == playsLeft) {
+            // walked by pointer, an index would take a multiply per entry
+            if (nullptr == entry || &(Song::entries()[Song::ENTRIES_COUNT]) == entry) {
+                entry = Song::entries();
+            }
+            pattern = pgm_read_byte(&(entry->pattern));
+            playsLeft = pgm_read_byte(&(entry->plays));
+            transpose = static_cast<int8_t>(pgm_read_byte(&(entry->transpose)));
+            entry++;
+        }
+        playsLeft--;
+        position = MelodyStreamDetails::readPosition(&(Song::patternStarts()[pattern]));
+        patternEnd = MelodyStreamDetails::readPosition(&(Song::patternStarts()[pattern + 1u]));
+    }
+
+    // four calls to it in next(), the nibble pick is worth a call
+    __attribute__((noinline))
+    uint8_t peek() const {
+        const uint8_t byte = pgm_read_byte(&(Song::codes()[position / 2u]));
+        return 0 == position % 2u ? byte >> 4u : byte & 0x0Fu;
+    }
+
+    inline __attribute__((always_inline))
+    uint8_t read() {
+        const uint8_t code = peek();
+        position++;
+        return code;
+    }
+};
+
+#endif // MTBX_MELODY_STREAM_H
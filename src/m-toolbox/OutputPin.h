@@ -18,6 +18,13 @@ private:
     typedef BitAccess<PINRegister, PinBit> dataReadOrToggle;
 
 public:
+    // for PinGroup
+    static const uint8_t groupStateRegister = PORTRegister;
+
+    static const uint8_t groupInputRegister = PINRegister;
+
+    static const uint8_t groupMask = BIT_MASK(PinBit);
+
     inline __attribute__((always_inline))
     static void init() {
         dataDirection::set();
@@ -37,6 +44,12 @@ public:
     static void set(bool isSet) {
         dataOutput::set(isSet);
     }
+
+    // a one written to PINx toggles that bit of PORTx, a plain write leaves the other pins alone
+    inline __attribute__((always_inline))
+    static void toggle() {
+        ACCESS_BYTE(PINRegister) = BIT_MASK(PinBit);
+    }
 };
 
 #endif // MTBX_OUTPUT_PIN_H
@@ -0,0 +1,137 @@
+#ifndef MTBX_PIN_GROUP_H
+#define MTBX_PIN_GROUP_H
+
+#include "Macro.h"
+
+// several pins of the same port driven with one register access
+// masks are folded at compile time, so setting the group is a single load/mask/store,
+// or a single sbi/cbi when the group has only one pin
+// pins (ComboPin, OutputPin) describe where their state lives:
+//   groupStateRegister - register that set() writes (DDR for ComboPin, PORT for OutputPin)
+//   groupInputRegister - register that read() reads
+//   groupMask          - pin bit
+// group bit i belongs to i-th pin in template arguments order
+
+namespace PinGroupDetails {
+    template <typename... Pins>
+    struct Fold;
+
+    template <typename Pin>
+    struct Fold<Pin> {
+        static const uint8_t mask = Pin::groupMask;
+
+        static const bool isSameRegisters = true;
+
+        static const uint8_t stateRegister = Pin::groupStateRegister;
+
+        static const uint8_t inputRegister = Pin::groupInputRegister;
+
+        // pins occupy consecutive register bits in group order
+        static const bool isContiguous = true;
+
+        static const uint8_t lowestMask = Pin::groupMask;
+
+        static constexpr uint8_t spread(const uint8_t groupBits, const uint8_t index) {
+            return (groupBits & (1u << index)) ? Pin::groupMask : 0u;
+        }
+
+        static constexpr uint8_t gather(const uint8_t registerBits, const uint8_t index) {
+            return (registerBits & Pin::groupMask) ? (1u << index) : 0u;
+        }
+    };
+
+    template <typename Pin, typename... Rest>
+    struct Fold<Pin, Rest...> {
+        typedef Fold<Rest...> RestFold;
+
+        static const uint8_t mask = Pin::groupMask | RestFold::mask;
+
+        static const bool isSameRegisters = RestFold::isSameRegisters
+                && Pin::groupStateRegister == RestFold::stateRegister
+                && Pin::groupInputRegister == RestFold::inputRegister;
+
+        static const uint8_t stateRegister = Pin::groupStateRegister;
+
+        static const uint8_t inputRegister = Pin::groupInputRegister;
+
+        static const bool isContiguous = RestFold::isContiguous
+                && static_cast<uint8_t>(Pin::groupMask << 1u) == RestFold::lowestMask;
+
+        static const uint8_t lowestMask = Pin::groupMask;
+
+        static constexpr uint8_t spread(const uint8_t groupBits, const uint8_t index) {
+            return ((groupBits & (1u << index)) ? Pin::groupMask : 0u) | RestFold::spread(groupBits, index + 1u);
+        }
+
+        static constexpr uint8_t gather(const uint8_t registerBits, const uint8_t index) {
+            return ((registerBits & Pin::groupMask) ? (1u << index) : 0u) | RestFold::gather(registerBits, index + 1u);
+        }
+    };
+
+    constexpr bool isSingleBit(const uint8_t mask) {
+        return 0 != mask && 0 == (mask & (mask - 1u));
+    }
+}
+
+template <typename... Pins>
+class PinGroup {
+private:
+    typedef PinGroupDetails::Fold<Pins...> fold;
+
+    static_assert(0 != sizeof...(Pins) && sizeof...(Pins) <= 8, "group is 1 to 8 pins");
+
+    static_assert(fold::isSameRegisters, "grouped pins must share their registers");
+
+    static const uint8_t stateRegister = fold::stateRegister;
+
+    static const uint8_t inputRegister = fold::inputRegister;
+
+    PinGroup() = default;
+
+public:
+    static const uint8_t mask = fold::mask;
+
+    // register bits of group bits
+    inline __attribute__((always_inline))
+    static constexpr uint8_t registerBits(const uint8_t groupBits) {
+        return fold::isContiguous
+               ? static_cast<uint8_t>(groupBits * fold::lowestMask) & mask
+               : fold::spread(groupBits, 0);
+    }
+
+    // group bits of register bits
+    inline __attribute__((always_inline))
+    static constexpr uint8_t groupBits(const uint8_t registerBits) {
+        return fold::isContiguous
+               ? static_cast<uint8_t>((registerBits & mask) / fold::lowestMask)
+               : fold::gather(registerBits, 0);
+    }
+
+    inline __attribute__((always_inline))
+    static void setAll() {
+        ACCESS_BYTE(stateRegister) |= mask;
+    }
+
+    inline __attribute__((always_inline))
+    static void clearAll() {
+        ACCESS_BYTE(stateRegister) &= static_cast<uint8_t>(~mask);
+    }
+
+    inline __attribute__((always_inline))
+    static void set(const uint8_t groupBits) {
+        if (PinGroupDetails::isSingleBit(mask)) {
+            (0 != (groupBits & 0b1u)) ? setAll() : clearAll();
+        } else {
+            ACCESS_BYTE(stateRegister) = (ACCESS_BYTE(stateRegister) & static_cast<uint8_t>(~mask))
+                    | registerBits(groupBits);
+        }
+    }
+
+    // raw input register bits of the group, in register positions
+    inline __attribute__((always_inline))
+    static uint8_t read() {
+        return ACCESS_BYTE(inputRegister) & mask;
+    }
+};
+
+#endif // MTBX_PIN_GROUP_H
@@ -0,0 +1,31 @@
+#include "StackPaint.h"
+
+#ifdef STACK_PAINT
+
+uint8_t StackPaint::highWater = 0;
+
+bool StackPaint::track() {
+    const uint8_t used = usedBytes();
+    if (used <= highWater) {
+        return false;
+    }
+    highWater = used;
+    return true;
+}
+
+// nothing is set up yet in .init1: no zero register, no stack frame, so plain asm
+// attiny13a sram ends below 0x100, only the low byte of the pointer is compared
+__attribute__((naked, used, section(".init1")))
+void paintStack() {
+    __asm__ __volatile__ (
+        "    ldi r30, lo8(_end)      \n"
+        "    ldi r31, hi8(_end)      \n"
+        "    ldi r24, %[pattern]     \n"
+        "1:  st Z+, r24              \n"
+        "    cpi r30, lo8(__stack + 1)\n"
+        "    brne 1b                 \n"
+        :
+        : [pattern] "M" (StackPaint::PATTERN));
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef MTBX_STACK_PAINT_H
+#define MTBX_STACK_PAINT_H
+
+#include <stdint.h>
+
+// debug aid, measures how deep the stack has ever been
+// with STACK_PAINT defined, StackPaint.cpp fills sram between the end of .data/.bss (_end)
+// and RAMEND (__stack) with PATTERN from .init1, before anything else runs;
+// the stack grows down from RAMEND, so the lowest overwritten byte is its high-water mark
+
+extern uint8_t _end;
+
+extern uint8_t __stack;
+
+namespace StackPaint {
+    const uint8_t PATTERN = 0xc5;
+
+    // deepest stack seen by track(), bytes
+    extern uint8_t highWater;
+
+    // bytes the stack has written to since reset
+    inline uint8_t usedBytes() {
+        const volatile uint8_t* untouched = &_end;
+        while (untouched <= &__stack && PATTERN == *untouched) {
+            untouched++;
+        }
+        return static_cast<uint8_t>(&__stack - untouched + 1);
+    }
+
+    // updates highWater, true when it has grown
+    bool track();
+}
+
+#endif // MTBX_STACK_PAINT_H
@@ -0,0 +1,93 @@
+#ifndef MTBX_VERTICAL_DEBOUNCER_H
+#define MTBX_VERTICAL_DEBOUNCER_H
+
+#include <stdint.h>
+
+// debounces up to 8 inputs at once, one bit per input in every byte
+// each input has its own CounterBits-bit counter, stored "vertically":
+// counter[0] holds bit 0 of all 8 counters, counter[1] bit 1 and so on
+// counter of an input runs only while its sample differs from the debounced state,
+// when it overflows (2^CounterBits differing samples in a row) the state flips
+// a sample matching the state restarts the counter
+
+namespace VerticalDebouncerDetails {
+    template <uint8_t Plane>
+    struct IncrementStep {
+        // adds carry to the counters, returns carry out of the top plane
+        inline __attribute__((always_inline))
+        static uint8_t apply(uint8_t* const counter, uint8_t carry) {
+            carry = IncrementStep<Plane - 1>::apply(counter, carry);
+            const uint8_t plane = counter[Plane];
+            counter[Plane] = plane ^ carry;
+            return plane & carry;
+        }
+    };
+
+    template <>
+    struct IncrementStep<0> {
+        inline __attribute__((always_inline))
+        static uint8_t apply(uint8_t* const counter, const uint8_t carry) {
+            const uint8_t plane = counter[0];
+            counter[0] = plane ^ carry;
+            return plane & carry;
+        }
+    };
+
+    template <uint8_t Plane>
+    struct RestartStep {
+        inline __attribute__((always_inline))
+        static void apply(uint8_t* const counter, const uint8_t running) {
+            counter[Plane] &= running;
+            RestartStep<Plane - 1>::apply(counter, running);
+        }
+    };
+
+    template <>
+    struct RestartStep<0> {
+        inline __attribute__((always_inline))
+        static void apply(uint8_t* const counter, const uint8_t running) {
+            counter[0] &= running;
+        }
+    };
+}
+
+template <uint8_t CounterBits>
+class VerticalDebouncer {
+    static_assert(0 != CounterBits && CounterBits <= 8, "counter is 1 to 8 bits");
+
+public:
+    // set bits are inputs that are on
+    inline __attribute__((always_inline))
+    void update(const uint8_t sample) {
+        const uint8_t differing = sample ^ state;
+        VerticalDebouncerDetails::RestartStep<CounterBits - 1>::apply(counter, differing);
+        toggled = VerticalDebouncerDetails::IncrementStep<CounterBits - 1>::apply(counter, differing);
+        state ^= toggled;
+    }
+
+    inline __attribute__((always_inline))
+    uint8_t held() const {
+        return state;
+    }
+
+    // inputs that turned on during the latest update
+    inline __attribute__((always_inline))
+    uint8_t risingEdges() const {
+        return toggled & state;
+    }
+
+    // inputs that turned off during the latest update
+    inline __attribute__((always_inline))
+    uint8_t fallingEdges() const {
+        return toggled & static_cast<uint8_t>(~state);
+    }
+
+private:
+    uint8_t state = 0;
+
+    uint8_t toggled = 0;
+
+    uint8_t counter[CounterBits] = {};
+};
+
+#endif // MTBX_VERTICAL_DEBOUNCER_H
@@ -0,0 +1,41 @@
+#ifndef HOST_SHIM_AVR_INTERRUPT_H
+#define HOST_SHIM_AVR_INTERRUPT_H
+
+// host stand-in for <avr/interrupt.h>
+// every ISR body becomes a plain function registered in the simulated vector table
+
+#include <avr/io.h>
+
+namespace hostsim {
+    typedef void (*VectorHandler)();
+
+    void registerVector(uint8_t vectorNumber, VectorHandler handler);
+
+    void globalInterruptsEnable();
+
+    void globalInterruptsDisable();
+
+    struct VectorRegistration {
+        VectorRegistration(const uint8_t vectorNumber, const VectorHandler handler) {
+            registerVector(vectorNumber, handler);
+        }
+    };
+}
+
+#define sei() (hostsim::globalInterruptsEnable())
+#define cli() (hostsim::globalInterruptsDisable())
+
+#define reti() return
+
+#define ISR(vector, ...) \
+    static void vector##_handler(); \
+    static const hostsim::VectorRegistration vector##_registration(vector##_num, &vector##_handler); \
+    static void vector##_handler()
+
+#define EMPTY_INTERRUPT(vector) ISR(vector) {}
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#endif // HOST_SHIM_AVR_INTERRUPT_H
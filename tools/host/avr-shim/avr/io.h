@@ -0,0 +1,231 @@
+#ifndef HOST_SHIM_AVR_IO_H
+#define HOST_SHIM_AVR_IO_H
+
+// host stand-in for <avr/io.h> of attiny13a
+// registers are plain data memory addresses (same as _SFR_ASM_COMPAT on avr-libc)
+// and every access goes through hostsim::RegisterRef, so simulated peripherals
+// see reads and writes the moment firmware does them
+
+#include <stdint.h>
+
+namespace hostsim {
+    uint8_t registerRead(uint8_t address);
+
+    void registerWrite(uint8_t address, uint8_t value);
+
+    class RegisterRef {
+    private:
+        const uint8_t address;
+
+    public:
+        explicit RegisterRef(const uint8_t address) : address(address) {
+        }
+
+        operator uint8_t() const {
+            return registerRead(address);
+        }
+
+        const RegisterRef& operator=(const uint8_t value) const {
+            registerWrite(address, value);
+            return *this;
+        }
+
+        const RegisterRef& operator=(const RegisterRef& other) const {
+            return *this = static_cast<uint8_t>(other);
+        }
+
+        const RegisterRef& operator|=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this | value);
+        }
+
+        const RegisterRef& operator&=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this & value);
+        }
+
+        const RegisterRef& operator^=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this ^ value);
+        }
+
+        const RegisterRef& operator+=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this + value);
+        }
+
+        const RegisterRef& operator-=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this - value);
+        }
+
+        const RegisterRef& operator<<=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this << value);
+        }
+
+        const RegisterRef& operator>>=(const unsigned int value) const {
+            return *this = static_cast<uint8_t>(*this >> value);
+        }
+
+        const RegisterRef& operator++() const {
+            return *this += 1u;
+        }
+
+        const RegisterRef& operator--() const {
+            return *this -= 1u;
+        }
+    };
+}
+
+#define __SFR_OFFSET 0x20
+
+#define _SFR_IO8(io_addr)   ((io_addr) + __SFR_OFFSET)
+#define _SFR_IO16(io_addr)  ((io_addr) + __SFR_OFFSET)
+
+#define _SFR_BYTE(sfr)      (hostsim::RegisterRef(sfr))
+
+#define _BV(bit)            (1u << (bit))
+
+// -------- REGISTERS --------
+
+#define ADCSRB  _SFR_IO8(0x03)
+#define ADCL    _SFR_IO8(0x04)
+#define ADCH    _SFR_IO8(0x05)
+#define ADCSRA  _SFR_IO8(0x06)
+#define ADMUX   _SFR_IO8(0x07)
+#define ACSR    _SFR_IO8(0x08)
+#define DIDR0   _SFR_IO8(0x14)
+#define PCMSK   _SFR_IO8(0x15)
+#define PINB    _SFR_IO8(0x16)
+#define DDRB    _SFR_IO8(0x17)
+#define PORTB   _SFR_IO8(0x18)
+#define EECR    _SFR_IO8(0x1C)
+#define EEDR    _SFR_IO8(0x1D)
+#define EEARL   _SFR_IO8(0x1E)
+#define EEAR    EEARL
+#define WDTCR   _SFR_IO8(0x21)
+#define PRR     _SFR_IO8(0x25)
+#define CLKPR   _SFR_IO8(0x26)
+#define GTCCR   _SFR_IO8(0x28)
+#define OCR0B   _SFR_IO8(0x29)
+#define DWDR    _SFR_IO8(0x2E)
+#define TCCR0A  _SFR_IO8(0x2F)
+#define BODCR   _SFR_IO8(0x30)
+#define OSCCAL  _SFR_IO8(0x31)
+#define TCNT0   _SFR_IO8(0x32)
+#define TCCR0B  _SFR_IO8(0x33)
+#define MCUSR   _SFR_IO8(0x34)
+#define MCUCR   _SFR_IO8(0x35)
+#define OCR0A   _SFR_IO8(0x36)
+#define SPMCSR  _SFR_IO8(0x37)
+#define TIFR0   _SFR_IO8(0x38)
+#define TIMSK0  _SFR_IO8(0x39)
+#define GIFR    _SFR_IO8(0x3A)
+#define GIMSK   _SFR_IO8(0x3B)
+#define SPL     _SFR_IO8(0x3D)
+#define SREG    _SFR_IO8(0x3F)
+
+// -------- BITS --------
+
+#define ACME    6
+#define ADTS2   2
+#define ADTS1   1
+#define ADTS0   0
+
+#define PB5     5
+#define PB4     4
+#define PB3     3
+#define PB2     2
+#define PB1     1
+#define PB0     0
+
+#define PCINT5  5
+#define PCINT4  4
+#define PCINT3  3
+#define PCINT2  2
+#define PCINT1  1
+#define PCINT0  0
+
+#define EEPM1   5
+#define EEPM0   4
+#define EERIE   3
+#define EEMPE   2
+#define EEPE    1
+#define EERE    0
+
+#define WDTIF   7
+#define WDTIE   6
+#define WDP3    5
+#define WDCE    4
+#define WDE     3
+#define WDP2    2
+#define WDP1    1
+#define WDP0    0
+
+#define PRTIM0  1
+#define PRADC   0
+
+#define CLKPCE  7
+
+#define TSM     7
+#define PSR10   0
+
+#define COM0A1  7
+#define COM0A0  6
+#define COM0B1  5
+#define COM0B0  4
+#define WGM01   1
+#define WGM00   0
+
+#define FOC0A   7
+#define FOC0B   6
+#define WGM02   3
+#define CS02    2
+#define CS01    1
+#define CS00    0
+
+#define WDRF    3
+#define BORF    2
+#define EXTRF   1
+#define PORF    0
+
+#define PUD     6
+#define SE      5
+#define SM1     4
+#define SM0     3
+#define ISC01   1
+#define ISC00   0
+
+#define OCF0B   3
+#define OCF0A   2
+#define TOV0    1
+
+#define OCIE0B  3
+#define OCIE0A  2
+#define TOIE0   1
+
+#define INTF0   6
+#define PCIF    5
+
+#define INT0    6
+#define PCIE    5
+
+#define SREG_I  7
+
+// -------- VECTORS --------
+
+#define INT0_vect_num           1
+#define PCINT0_vect_num         2
+#define TIM0_OVF_vect_num       3
+#define EE_RDY_vect_num         4
+#define ANA_COMP_vect_num       5
+#define TIM0_COMPA_vect_num     6
+#define TIM0_COMPB_vect_num     7
+#define WDT_vect_num            8
+#define ADC_vect_num            9
+
+#define _VECTORS_SIZE           20
+
+// -------- MEMORY --------
+
+#define RAMSTART    0x60
+#define RAMEND      0x9F
+#define FLASHEND    0x3FF
+#define E2END       0x3F
+
+#endif // HOST_SHIM_AVR_IO_H
@@ -0,0 +1,21 @@
+#ifndef HOST_SHIM_AVR_PGMSPACE_H
+#define HOST_SHIM_AVR_PGMSPACE_H
+
+// host stand-in for <avr/pgmspace.h>
+// flash data lives in ordinary host memory
+
+#include <stdint.h>
+
+#define PROGMEM
+
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address)  (*reinterpret_cast<const uint8_t*>(address))
+#define pgm_read_word(address)  (*reinterpret_cast<const uint16_t*>(address))
+#define pgm_read_dword(address) (*reinterpret_cast<const uint32_t*>(address))
+#define pgm_read_ptr(address)   (*reinterpret_cast<void* const*>(address))
+
+#define pgm_read_byte_near(address) pgm_read_byte(address)
+#define pgm_read_word_near(address) pgm_read_word(address)
+
+#endif // HOST_SHIM_AVR_PGMSPACE_H
@@ -0,0 +1,12 @@
+#ifndef HOST_SHIM_AVR_WDT_H
+#define HOST_SHIM_AVR_WDT_H
+
+// host stand-in for <avr/wdt.h>
+
+namespace hostsim {
+    void watchdogReset();
+}
+
+#define wdt_reset() (hostsim::watchdogReset())
+
+#endif // HOST_SHIM_AVR_WDT_H
@@ -0,0 +1,21 @@
+#ifndef HOST_SHIM_UTIL_DELAY_H
+#define HOST_SHIM_UTIL_DELAY_H
+
+// host stand-in for <util/delay.h>
+// delays advance simulated time instead of spinning
+
+#include <stdint.h>
+
+namespace hostsim {
+    void advanceCycles(uint32_t cycles);
+}
+
+inline void _delay_ms(const double ms) {
+    hostsim::advanceCycles(static_cast<uint32_t>(ms * (F_CPU / 1000.0)));
+}
+
+inline void _delay_us(const double us) {
+    hostsim::advanceCycles(static_cast<uint32_t>(us * (F_CPU / 1000000.0)));
+}
+
+#endif // HOST_SHIM_UTIL_DELAY_H
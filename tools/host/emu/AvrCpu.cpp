@@ -0,0 +1,664 @@
+#include "AvrCpu.h"
+
+#include "../sim/HostSim.h"
+
+#include <avr/io.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    const uint8_t FLAG_C = 0;
+    const uint8_t FLAG_Z = 1;
+    const uint8_t FLAG_N = 2;
+    const uint8_t FLAG_V = 3;
+    const uint8_t FLAG_S = 4;
+    const uint8_t FLAG_H = 5;
+    const uint8_t FLAG_T = 6;
+    const uint8_t FLAG_I = 7;
+
+    // pointer registers, low byte index
+    const uint8_t X = 26;
+    const uint8_t Y = 28;
+    const uint8_t Z = 30;
+
+    const uint32_t INTERRUPT_RESPONSE_CYCLES = 4;
+
+    const uint32_t SLEEP_WAKE_CYCLES = 4;
+
+    // i/o address of SPH, attiny13a has 8-bit stack pointer only
+    const uint8_t SPH_ADDRESS = 0x5E;
+
+    bool bit(const uint8_t value, const uint8_t index) {
+        return 0 != (value & (1u << index));
+    }
+
+    // i/o register bits cleared by writing one
+    uint8_t flagBits(const uint8_t address) {
+        switch (address) {
+            case TIFR0: return _BV(OCF0B) | _BV(OCF0A) | _BV(TOV0);
+            case GIFR: return _BV(INTF0) | _BV(PCIF);
+            case WDTCR: return _BV(WDTIF);
+            default: return 0;
+        }
+    }
+
+    // 0000 00rd dddd rrrr style operands
+    uint8_t fieldD5(const uint16_t opcode) {
+        return static_cast<uint8_t>((opcode >> 4u) & 0x1Fu);
+    }
+
+    uint8_t fieldR5(const uint16_t opcode) {
+        return static_cast<uint8_t>((opcode & 0x0Fu) | ((opcode >> 5u) & 0x10u));
+    }
+
+    // r16..r31 with 8-bit immediate
+    uint8_t fieldD4(const uint16_t opcode) {
+        return static_cast<uint8_t>(16u + ((opcode >> 4u) & 0x0Fu));
+    }
+
+    uint8_t fieldK8(const uint16_t opcode) {
+        return static_cast<uint8_t>((opcode & 0x0Fu) | ((opcode >> 4u) & 0xF0u));
+    }
+
+    int16_t fieldRelative12(const uint16_t opcode) {
+        const int16_t k = static_cast<int16_t>(opcode & 0x0FFFu);
+        return k >= 0x800 ? static_cast<int16_t>(k - 0x1000) : k;
+    }
+
+    int8_t fieldRelative7(const uint16_t opcode) {
+        const int8_t k = static_cast<int8_t>((opcode >> 3u) & 0x7Fu);
+        return k >= 0x40 ? static_cast<int8_t>(k - 0x80) : k;
+    }
+}
+
+AvrCpu::AvrCpu(const std::vector<uint8_t>& image) {
+    for (uint16_t i = 0; i < FLASH_WORDS; i++) {
+        const size_t at = 2u * i;
+        const uint8_t low = at < image.size() ? image[at] : 0xFFu;
+        const uint8_t high = at + 1 < image.size() ? image[at + 1] : 0xFFu;
+        flash[i] = static_cast<uint16_t>(low | high << 8u);
+    }
+    reset();
+}
+
+void AvrCpu::reset() {
+    memset(r, 0, sizeof(r));
+    memset(sram, 0, sizeof(sram));
+    sreg = 0;
+    stackPointer = RAMEND;
+    lowestStackPointer = RAMEND;
+    programCounter = 0;
+    instructionPc = 0;
+    isInterruptDelayed = false;
+    isSleeping = false;
+    takenVector = 0;
+}
+
+uint32_t AvrCpu::step() {
+    takenVector = 0;
+    if (flag(FLAG_I) && !isInterruptDelayed) {
+        const uint8_t vectorNumber = hostsim::takeInterrupt();
+        if (0 != vectorNumber) {
+            takenVector = vectorNumber;
+            instructionPc = programCounter;
+            pushPc(programCounter);
+            setFlag(FLAG_I, false);
+            // vector table is one rjmp per vector
+            programCounter = vectorNumber;
+            const uint32_t cycles = INTERRUPT_RESPONSE_CYCLES + (isSleeping ? SLEEP_WAKE_CYCLES : 0);
+            isSleeping = false;
+            return cycles;
+        }
+    }
+    isInterruptDelayed = false;
+    isSleeping = false;
+    instructionPc = programCounter;
+    return execute(fetch());
+}
+
+uint8_t AvrCpu::data(const uint16_t address) {
+    if (address < 0x20) {
+        return r[address];
+    }
+    if (address < RAM_START) {
+        return readIo(static_cast<uint8_t>(address));
+    }
+    if (address < RAM_START + RAM_SIZE) {
+        return sram[address - RAM_START];
+    }
+    fault("read outside the data space");
+}
+
+void AvrCpu::writeData(const uint16_t address, const uint8_t value) {
+    if (address < 0x20) {
+        r[address] = value;
+    } else if (address < RAM_START) {
+        writeIo(static_cast<uint8_t>(address), value);
+    } else if (address < RAM_START + RAM_SIZE) {
+        sram[address - RAM_START] = value;
+    } else {
+        fault("write outside the data space");
+    }
+}
+
+uint8_t AvrCpu::readIo(const uint8_t address) {
+    switch (address) {
+        case SREG: return sreg;
+        case SPL: return stackPointer;
+        case SPH_ADDRESS: return 0;
+        default: return hostsim::registerRead(address);
+    }
+}
+
+void AvrCpu::writeIo(const uint8_t address, const uint8_t value) {
+    switch (address) {
+        case SREG:
+            sreg = value;
+            break;
+        case SPL:
+            stackPointer = value;
+            break;
+        case SPH_ADDRESS:
+            break;
+        default:
+            hostsim::registerWrite(address, value);
+            break;
+    }
+}
+
+void AvrCpu::writeIoBit(const uint8_t address, const uint8_t index, const bool isSet) {
+    const uint8_t mask = static_cast<uint8_t>(1u << index);
+    // pins are not read back: sbi writes a one to that bit alone, so it toggles one pin, cbi toggles none
+    if (PINB == address) {
+        writeIo(address, isSet ? mask : 0);
+        return;
+    }
+    const uint8_t value = readIo(address) & static_cast<uint8_t>(~flagBits(address));
+    writeIo(address, isSet ? (value | mask) : (value & static_cast<uint8_t>(~mask)));
+}
+
+void AvrCpu::push(const uint8_t value) {
+    if (stackPointer < RAM_START) {
+        fault("stack overflow");
+    }
+    writeData(stackPointer, value);
+    stackPointer--;
+    lowestStackPointer = stackPointer < lowestStackPointer ? stackPointer : lowestStackPointer;
+}
+
+uint8_t AvrCpu::pop() {
+    stackPointer++;
+    return data(stackPointer);
+}
+
+// return address goes low byte first, so it reads big endian from the stack pointer up
+void AvrCpu::pushPc(const uint16_t pc) {
+    push(static_cast<uint8_t>(pc));
+    push(static_cast<uint8_t>(pc >> 8u));
+}
+
+uint16_t AvrCpu::popPc() {
+    const uint8_t high = pop();
+    const uint8_t low = pop();
+    return static_cast<uint16_t>((high << 8u | low) % FLASH_WORDS);
+}
+
+uint16_t AvrCpu::pointer(const uint8_t low) const {
+    return static_cast<uint16_t>(r[low] | r[low + 1] << 8u);
+}
+
+void AvrCpu::setPointer(const uint8_t low, const uint16_t value) {
+    r[low] = static_cast<uint8_t>(value);
+    r[low + 1] = static_cast<uint8_t>(value >> 8u);
+}
+
+void AvrCpu::setFlag(const uint8_t index, const bool value) {
+    sreg = value ? (sreg | (1u << index)) : (sreg & ~(1u << index));
+}
+
+bool AvrCpu::flag(const uint8_t index) const {
+    return bit(sreg, index);
+}
+
+void AvrCpu::setZNS(const uint8_t result, const bool overflow) {
+    setFlag(FLAG_V, overflow);
+    setFlag(FLAG_N, bit(result, 7));
+    setFlag(FLAG_S, bit(result, 7) != overflow);
+    setFlag(FLAG_Z, 0 == result);
+}
+
+uint8_t AvrCpu::add(const uint8_t d, const uint8_t rr, const bool carry) {
+    const uint8_t result = static_cast<uint8_t>(d + rr + (carry ? 1u : 0u));
+    const uint8_t carries = (d & rr) | (rr & ~result) | (~result & d);
+    setFlag(FLAG_H, bit(carries, 3));
+    setFlag(FLAG_C, bit(carries, 7));
+    setZNS(result, bit((d & rr & ~result) | (~d & ~rr & result), 7));
+    return result;
+}
+
+uint8_t AvrCpu::subtract(const uint8_t d, const uint8_t rr, const bool carry, const bool keepZero) {
+    const uint8_t result = static_cast<uint8_t>(d - rr - (carry ? 1u : 0u));
+    const uint8_t borrows = (~d & rr) | (rr & result) | (result & ~d);
+    const bool wasZero = flag(FLAG_Z);
+    setFlag(FLAG_H, bit(borrows, 3));
+    setFlag(FLAG_C, bit(borrows, 7));
+    setZNS(result, bit((d & ~rr & ~result) | (~d & rr & result), 7));
+    if (keepZero) {
+        // sbc/sbci/cpc: zero only stays set over the whole multi-byte result
+        setFlag(FLAG_Z, wasZero && 0 == result);
+    }
+    return result;
+}
+
+void AvrCpu::logic(const uint8_t result) {
+    setZNS(result, false);
+}
+
+uint16_t AvrCpu::fetch() {
+    const uint16_t opcode = flash[programCounter];
+    programCounter = static_cast<uint16_t>((programCounter + 1u) % FLASH_WORDS);
+    return opcode;
+}
+
+bool AvrCpu::isTwoWords(const uint16_t opcode) const {
+    // lds, sts, jmp, call
+    return 0x9000u == (opcode & 0xFC0Fu) || 0x940Cu == (opcode & 0xFE0Cu);
+}
+
+uint32_t AvrCpu::skip() {
+    const uint16_t next = fetch();
+    if (isTwoWords(next)) {
+        fetch();
+        return 2;
+    }
+    return 1;
+}
+
+void AvrCpu::fault(const std::string& message) const {
+    throw AvrFault { message, instructionPc };
+}
+
+uint32_t AvrCpu::execute(const uint16_t opcode) {
+    const uint8_t d = fieldD5(opcode);
+    const uint8_t rr = fieldR5(opcode);
+
+    switch (opcode >> 12u) {
+        case 0x0:
+            switch ((opcode >> 10u) & 0b11u) {
+                case 0:
+                    if (0x0000u == opcode) {
+                        return 1;
+                    }
+                    if (0x0100u == (opcode & 0xFF00u)) {
+                        // movw
+                        const uint8_t to = static_cast<uint8_t>(((opcode >> 4u) & 0x0Fu) * 2u);
+                        const uint8_t from = static_cast<uint8_t>((opcode & 0x0Fu) * 2u);
+                        r[to] = r[from];
+                        r[to + 1] = r[from + 1];
+                        return 1;
+                    }
+                    break;
+                case 1:
+                    subtract(r[d], r[rr], flag(FLAG_C), true);
+                    return 1;
+                case 2:
+                    r[d] = subtract(r[d], r[rr], flag(FLAG_C), true);
+                    return 1;
+                case 3:
+                    r[d] = add(r[d], r[rr], false);
+                    return 1;
+            }
+            break;
+        case 0x1:
+            switch ((opcode >> 10u) & 0b11u) {
+                case 0:
+                    return r[d] == r[rr] ? 1u + skip() : 1u;
+                case 1:
+                    subtract(r[d], r[rr], false, false);
+                    return 1;
+                case 2:
+                    r[d] = subtract(r[d], r[rr], false, false);
+                    return 1;
+                case 3:
+                    r[d] = add(r[d], r[rr], flag(FLAG_C));
+                    return 1;
+            }
+            break;
+        case 0x2:
+            switch ((opcode >> 10u) & 0b11u) {
+                case 0:
+                    r[d] &= r[rr];
+                    logic(r[d]);
+                    return 1;
+                case 1:
+                    r[d] ^= r[rr];
+                    logic(r[d]);
+                    return 1;
+                case 2:
+                    r[d] |= r[rr];
+                    logic(r[d]);
+                    return 1;
+                case 3:
+                    r[d] = r[rr];
+                    return 1;
+            }
+            break;
+        case 0x3:
+            subtract(r[fieldD4(opcode)], fieldK8(opcode), false, false);
+            return 1;
+        case 0x4:
+            r[fieldD4(opcode)] = subtract(r[fieldD4(opcode)], fieldK8(opcode), flag(FLAG_C), true);
+            return 1;
+        case 0x5:
+            r[fieldD4(opcode)] = subtract(r[fieldD4(opcode)], fieldK8(opcode), false, false);
+            return 1;
+        case 0x6:
+            r[fieldD4(opcode)] |= fieldK8(opcode);
+            logic(r[fieldD4(opcode)]);
+            return 1;
+        case 0x7:
+            r[fieldD4(opcode)] &= fieldK8(opcode);
+            logic(r[fieldD4(opcode)]);
+            return 1;
+        case 0x8:
+        case 0xA: {
+            // ldd/std with displacement, ld/st Y and Z without
+            const uint8_t q = static_cast<uint8_t>((opcode & 0x07u) | ((opcode >> 7u) & 0x18u) | ((opcode >> 8u) & 0x20u));
+            const uint16_t address = static_cast<uint16_t>(pointer(bit(static_cast<uint8_t>(opcode), 3) ? Y : Z) + q);
+            if (bit(static_cast<uint8_t>(opcode >> 8u), 1)) {
+                writeData(address, r[d]);
+            } else {
+                r[d] = data(address);
+            }
+            return 2;
+        }
+        case 0x9:
+            return executeGroup9(opcode, d, rr);
+        case 0xB: {
+            const uint8_t address = static_cast<uint8_t>(0x20u + ((opcode & 0x0Fu) | ((opcode >> 5u) & 0x30u)));
+            if (bit(static_cast<uint8_t>(opcode >> 8u), 3)) {
+                writeIo(address, r[d]);
+            } else {
+                r[d] = readIo(address);
+            }
+            return 1;
+        }
+        case 0xC:
+            programCounter = static_cast<uint16_t>((programCounter + fieldRelative12(opcode)) % FLASH_WORDS);
+            return 2;
+        case 0xD:
+            pushPc(programCounter);
+            programCounter = static_cast<uint16_t>((programCounter + fieldRelative12(opcode)) % FLASH_WORDS);
+            return 3;
+        case 0xE:
+            r[fieldD4(opcode)] = fieldK8(opcode);
+            return 1;
+        case 0xF: {
+            const uint8_t index = static_cast<uint8_t>(opcode & 0x07u);
+            switch ((opcode >> 9u) & 0b111u) {
+                case 0b000:
+                case 0b001:
+                case 0b010:
+                case 0b011: {
+                    // brbs / brbc
+                    const bool isSetBranch = !bit(static_cast<uint8_t>(opcode >> 8u), 2);
+                    if (flag(index) == isSetBranch) {
+                        programCounter = static_cast<uint16_t>((programCounter + fieldRelative7(opcode)) % FLASH_WORDS);
+                        return 2;
+                    }
+                    return 1;
+                }
+                case 0b100:
+                    if (!bit(static_cast<uint8_t>(opcode), 3)) {
+                        r[d] = flag(FLAG_T) ? (r[d] | (1u << index)) : (r[d] & ~(1u << index));
+                        return 1;
+                    }
+                    break;
+                case 0b101:
+                    if (!bit(static_cast<uint8_t>(opcode), 3)) {
+                        setFlag(FLAG_T, bit(r[d], index));
+                        return 1;
+                    }
+                    break;
+                case 0b110:
+                    return bit(r[d], index) ? 1u : 1u + skip();
+                case 0b111:
+                    return bit(r[d], index) ? 1u + skip() : 1u;
+            }
+            break;
+        }
+    }
+    char message[32];
+    snprintf(message, sizeof(message), "unknown opcode 0x%04x", opcode);
+    fault(message);
+}
+
+uint32_t AvrCpu::executeGroup9(const uint16_t opcode, const uint8_t d, const uint8_t rr) {
+    switch ((opcode >> 9u) & 0b111u) {
+        case 0b000:
+        case 0b001: {
+            const bool isStore = bit(static_cast<uint8_t>(opcode >> 8u), 1);
+            uint8_t pointerLow = 0;
+            int8_t preDecrement = 0;
+            bool isPostIncrement = false;
+            switch (opcode & 0x0Fu) {
+                case 0x0: {
+                    // lds / sts
+                    const uint16_t address = fetch();
+                    if (isStore) {
+                        writeData(address, r[d]);
+                    } else {
+                        r[d] = data(address);
+                    }
+                    return 2;
+                }
+                case 0x1: pointerLow = Z; isPostIncrement = true; break;
+                case 0x2: pointerLow = Z; preDecrement = 1; break;
+                case 0x9: pointerLow = Y; isPostIncrement = true; break;
+                case 0xA: pointerLow = Y; preDecrement = 1; break;
+                case 0xC: pointerLow = X; break;
+                case 0xD: pointerLow = X; isPostIncrement = true; break;
+                case 0xE: pointerLow = X; preDecrement = 1; break;
+                case 0x4:
+                case 0x5:
+                    if (!isStore) {
+                        // lpm Rd, Z / Z+
+                        const uint16_t address = pointer(Z);
+                        const uint16_t word = flash[(address >> 1u) % FLASH_WORDS];
+                        r[d] = static_cast<uint8_t>(bit(static_cast<uint8_t>(address), 0) ? word >> 8u : word);
+                        if (0x5u == (opcode & 0x0Fu)) {
+                            setPointer(Z, static_cast<uint16_t>(address + 1u));
+                        }
+                        return 3;
+                    }
+                    break;
+                case 0xF:
+                    if (isStore) {
+                        push(r[d]);
+                    } else {
+                        r[d] = pop();
+                    }
+                    return 2;
+                default:
+                    break;
+            }
+            if (0 == pointerLow) {
+                break;
+            }
+            uint16_t address = static_cast<uint16_t>(pointer(pointerLow) - preDecrement);
+            if (isStore) {
+                writeData(address, r[d]);
+            } else {
+                r[d] = data(address);
+            }
+            address = static_cast<uint16_t>(address + (isPostIncrement ? 1u : 0u));
+            setPointer(pointerLow, address);
+            return 2;
+        }
+        case 0b010: {
+            switch (opcode & 0x0Fu) {
+                case 0x0:
+                    r[d] = static_cast<uint8_t>(~r[d]);
+                    logic(r[d]);
+                    setFlag(FLAG_C, true);
+                    return 1;
+                case 0x1: {
+                    const uint8_t value = r[d];
+                    r[d] = static_cast<uint8_t>(-value);
+                    setFlag(FLAG_H, bit(r[d], 3) || bit(value, 3));
+                    setFlag(FLAG_C, 0 != r[d]);
+                    setZNS(r[d], 0x80u == r[d]);
+                    return 1;
+                }
+                case 0x2:
+                    r[d] = static_cast<uint8_t>(r[d] << 4u | r[d] >> 4u);
+                    return 1;
+                case 0x3:
+                    r[d]++;
+                    setZNS(r[d], 0x80u == r[d]);
+                    return 1;
+                case 0x5:
+                case 0x6:
+                case 0x7: {
+                    // asr / lsr / ror
+                    const uint8_t value = r[d];
+                    const uint8_t top = 0x5u == (opcode & 0x0Fu) ? (value & 0x80u)
+                            : 0x7u == (opcode & 0x0Fu) && flag(FLAG_C) ? 0x80u : 0u;
+                    r[d] = static_cast<uint8_t>(top | value >> 1u);
+                    setFlag(FLAG_C, bit(value, 0));
+                    setZNS(r[d], bit(r[d], 7) != bit(value, 0));
+                    return 1;
+                }
+                case 0x8:
+                    if (opcode & 0x0100u) {
+                        return executeControl(opcode);
+                    }
+                    // bset / bclr
+                    setFlag(static_cast<uint8_t>((opcode >> 4u) & 0x07u), !bit(static_cast<uint8_t>(opcode), 7));
+                    if (0x9478u == opcode) {
+                        isInterruptDelayed = true;
+                    }
+                    return 1;
+                case 0x9:
+                    if (0x9409u == opcode) {
+                        programCounter = static_cast<uint16_t>(pointer(Z) % FLASH_WORDS);
+                        return 2;
+                    }
+                    if (0x9509u == opcode) {
+                        pushPc(programCounter);
+                        programCounter = static_cast<uint16_t>(pointer(Z) % FLASH_WORDS);
+                        return 3;
+                    }
+                    break;
+                case 0xA:
+                    r[d]--;
+                    setZNS(r[d], 0x7Fu == r[d]);
+                    return 1;
+                case 0xC:
+                case 0xD:
+                case 0xE:
+                case 0xF: {
+                    // jmp / call, flash is small enough for the low word alone
+                    const uint16_t target = static_cast<uint16_t>(fetch() % FLASH_WORDS);
+                    if (opcode & 0x0002u) {
+                        pushPc(programCounter);
+                        programCounter = target;
+                        return 4;
+                    }
+                    programCounter = target;
+                    return 3;
+                }
+                default:
+                    break;
+            }
+            break;
+        }
+        case 0b011: {
+            // adiw / sbiw
+            const uint8_t low = static_cast<uint8_t>(24u + ((opcode >> 4u) & 0b11u) * 2u);
+            const uint8_t k = static_cast<uint8_t>((opcode & 0x0Fu) | ((opcode >> 2u) & 0x30u));
+            const uint16_t value = pointer(low);
+            const bool isAdd = !bit(static_cast<uint8_t>(opcode >> 8u), 0);
+            const uint16_t result = static_cast<uint16_t>(isAdd ? value + k : value - k);
+            setPointer(low, result);
+            const bool wasHigh = 0 != (value & 0x8000u);
+            const bool isHigh = 0 != (result & 0x8000u);
+            const bool overflow = isAdd ? !wasHigh && isHigh : wasHigh && !isHigh;
+            setFlag(FLAG_C, isAdd ? wasHigh && !isHigh : isHigh && !wasHigh);
+            setFlag(FLAG_V, overflow);
+            setFlag(FLAG_N, isHigh);
+            setFlag(FLAG_S, isHigh != overflow);
+            setFlag(FLAG_Z, 0 == result);
+            return 2;
+        }
+        case 0b100:
+        case 0b101: {
+            // cbi, sbic, sbi, sbis
+            const uint8_t address = static_cast<uint8_t>(0x20u + ((opcode >> 3u) & 0x1Fu));
+            const uint8_t index = static_cast<uint8_t>(opcode & 0x07u);
+            switch ((opcode >> 8u) & 0b11u) {
+                case 0:
+                    writeIoBit(address, index, false);
+                    return 2;
+                case 1:
+                    return bit(readIo(address), index) ? 1u : 1u + skip();
+                case 2:
+                    writeIoBit(address, index, true);
+                    return 2;
+                default:
+                    return bit(readIo(address), index) ? 1u + skip() : 1u;
+            }
+        }
+        default:
+            // mul is not there on attiny13a
+            break;
+    }
+    (void) rr;
+    char message[32];
+    snprintf(message, sizeof(message), "unknown opcode 0x%04x", opcode);
+    fault(message);
+}
+
+uint32_t AvrCpu::executeControl(const uint16_t opcode) {
+    switch (opcode) {
+        case 0x9508:
+            programCounter = popPc();
+            return 4;
+        case 0x9518:
+            programCounter = popPc();
+            setFlag(FLAG_I, true);
+            isInterruptDelayed = true;
+            return 4;
+        case 0x9588:
+            // sleep does nothing until sleep is enabled, modes other than power-down run as idle
+            if (hostsim::registerRead(MCUCR) & _BV(SE)) {
+                if (!flag(FLAG_I)) {
+                    fault("sleep with interrupts disabled never wakes");
+                }
+                const uint8_t mode = hostsim::registerRead(MCUCR) & (_BV(SM1) | _BV(SM0));
+                // sleep's own cycle passes before the cpu stops
+                hostsim::advanceCycles(1);
+                hostsim::sleepUntilInterrupt(_BV(SM1) == mode);
+                isSleeping = true;
+                return 0;
+            }
+            return 1;
+        case 0x9598:
+            fault("break");
+        case 0x95A8:
+            hostsim::watchdogReset();
+            return 1;
+        case 0x95C8: {
+            const uint16_t address = pointer(Z);
+            const uint16_t word = flash[(address >> 1u) % FLASH_WORDS];
+            r[0] = static_cast<uint8_t>(bit(static_cast<uint8_t>(address), 0) ? word >> 8u : word);
+            return 3;
+        }
+        default:
+            break;
+    }
+    char message[32];
+    snprintf(message, sizeof(message), "unknown opcode 0x%04x", opcode);
+    fault(message);
+}
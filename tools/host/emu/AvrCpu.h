@@ -0,0 +1,135 @@
+#ifndef HOST_AVR_CPU_H
+#define HOST_AVR_CPU_H
+
+// attiny13a core (AVRe without multiplier) running a flash image instruction by instruction
+// registers and sram live here, i/o registers other than SREG and SPL go to the host simulator
+// peripherals, which the caller advances by the cycles every step() returns
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// bad opcode, access outside the data space, stack overflow into i/o registers
+struct AvrFault {
+    std::string message;
+
+    // word address of the instruction
+    uint16_t pc;
+};
+
+class AvrCpu {
+public:
+    static const uint16_t FLASH_WORDS = 512;
+
+    explicit AvrCpu(const std::vector<uint8_t>& flash);
+
+    void reset();
+
+    // takes a pending interrupt or runs one instruction, returns the cycles it took
+    uint32_t step();
+
+    // word address of the next instruction
+    uint16_t pc() const {
+        return programCounter;
+    }
+
+    uint8_t sp() const {
+        return stackPointer;
+    }
+
+    // vector number of the interrupt the latest step() took, 0 when it ran an instruction
+    uint8_t lastVector() const {
+        return takenVector;
+    }
+
+    // lowest stack pointer seen since reset
+    uint8_t lowestSp() const {
+        return lowestStackPointer;
+    }
+
+    // data space: registers, i/o, sram
+    uint8_t data(uint16_t address);
+
+private:
+    static const uint16_t RAM_START = 0x60;
+
+    static const uint16_t RAM_SIZE = 64;
+
+    uint16_t flash[FLASH_WORDS];
+
+    uint8_t r[32];
+
+    uint8_t sram[RAM_SIZE];
+
+    uint8_t sreg;
+
+    uint8_t stackPointer;
+
+    uint8_t lowestStackPointer;
+
+    uint16_t programCounter;
+
+    // word address of the instruction being executed, for faults
+    uint16_t instructionPc;
+
+    // sei and reti let one more instruction run before an interrupt is taken
+    bool isInterruptDelayed;
+
+    // the next interrupt wakes the cpu from sleep
+    bool isSleeping;
+
+    uint8_t takenVector;
+
+    uint32_t execute(uint16_t opcode);
+
+    // 1001 xxxx: loads, stores, one operand, adiw/sbiw, bit i/o
+    uint32_t executeGroup9(uint16_t opcode, uint8_t d, uint8_t rr);
+
+    // ret, reti, sleep, break, wdr, lpm
+    uint32_t executeControl(uint16_t opcode);
+
+    uint16_t fetch();
+
+    bool isTwoWords(uint16_t opcode) const;
+
+    // skips the next instruction, returns the extra cycles
+    uint32_t skip();
+
+    void writeData(uint16_t address, uint8_t value);
+
+    uint8_t readIo(uint8_t address);
+
+    void writeIo(uint8_t address, uint8_t value);
+
+    // sbi/cbi touch only their bit, other flags in the register read as set are not cleared
+    void writeIoBit(uint8_t address, uint8_t bit, bool isSet);
+
+    void push(uint8_t value);
+
+    uint8_t pop();
+
+    void pushPc(uint16_t pc);
+
+    uint16_t popPc();
+
+    uint16_t pointer(uint8_t low) const;
+
+    void setPointer(uint8_t low, uint16_t value);
+
+    void setFlag(uint8_t bit, bool value);
+
+    bool flag(uint8_t bit) const;
+
+    void setZNS(uint8_t result, bool overflow);
+
+    uint8_t add(uint8_t d, uint8_t r, bool carry);
+
+    uint8_t subtract(uint8_t d, uint8_t r, bool carry, bool keepZero);
+
+    void logic(uint8_t result);
+
+    [[noreturn]] void fault(const std::string& message) const;
+};
+
+#endif // HOST_AVR_CPU_H
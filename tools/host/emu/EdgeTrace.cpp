@@ -0,0 +1,275 @@
+#include "EdgeTrace.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <map>
+
+namespace {
+    // event times are kept in 1/256 cycles, pwm crossings fall between edges
+    const uint32_t EVENT_SCALE = 256;
+
+    const uint32_t MAX_EDGES_PER_PERIOD = 16;
+
+    const uint32_t MIN_WINDOW_EVENTS = 8;
+
+    // distances k edges apart may differ this much within one note
+    const double PERIOD_TOLERANCE = 0.05;
+
+    // neighbour windows with periods this close are the same note
+    const double SAME_NOTE_TOLERANCE = 0.003;
+
+    // rising edges of a pwm output are this regular
+    const double CARRIER_SHARE = 0.8;
+
+    const uint32_t CARRIER_MAX_PERIOD = 1024;
+
+    struct Fit {
+        uint32_t k;
+
+        double period;
+    };
+
+    // smallest stride that makes event distances regular
+    bool fit(const std::vector<uint64_t>& events, const size_t first, const size_t last, Fit& result) {
+        if (last < first || last - first + 1 < MIN_WINDOW_EVENTS) {
+            return false;
+        }
+        for (uint32_t k = 1; k <= MAX_EDGES_PER_PERIOD && first + 2u * k <= last; k++) {
+            uint64_t min = UINT64_MAX;
+            uint64_t max = 0;
+            uint64_t sum = 0;
+            for (size_t i = first; i + k <= last; i++) {
+                const uint64_t distance = events[i + k] - events[i];
+                min = distance < min ? distance : min;
+                max = distance > max ? distance : max;
+                sum += distance;
+            }
+            const double mean = static_cast<double>(sum) / static_cast<double>(last - first + 1 - k);
+            if (static_cast<double>(max - min) <= PERIOD_TOLERANCE * mean) {
+                result = Fit { k, mean };
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+EdgeTrace::EdgeTrace(const uint32_t cpuFrequency) : cpuFrequency(cpuFrequency) {
+}
+
+void EdgeTrace::onLevel(const uint64_t cycle, const bool level) {
+    // level the pin starts with is not an edge
+    if (!hasLevel) {
+        hasLevel = true;
+        lastLevel = level;
+        return;
+    }
+    if (level != lastLevel) {
+        edges.push_back(Edge { cycle, level });
+        lastLevel = level;
+    }
+}
+
+uint32_t EdgeTrace::carrierPeriod() const {
+    std::map<uint64_t, size_t> intervals;
+    size_t risingCount = 0;
+    uint64_t lastRising = 0;
+    for (const Edge& edge : edges) {
+        if (!edge.level) {
+            continue;
+        }
+        if (0 != risingCount) {
+            intervals[edge.cycle - lastRising]++;
+        }
+        lastRising = edge.cycle;
+        risingCount++;
+    }
+    if (risingCount < 2) {
+        return 0;
+    }
+    uint64_t mostCommon = 0;
+    size_t mostCommonCount = 0;
+    for (const auto& interval : intervals) {
+        if (interval.second > mostCommonCount) {
+            mostCommon = interval.first;
+            mostCommonCount = interval.second;
+        }
+    }
+    const bool isCarrier = mostCommon <= CARRIER_MAX_PERIOD
+            && static_cast<double>(mostCommonCount) >= CARRIER_SHARE * static_cast<double>(risingCount - 1);
+    return isCarrier ? static_cast<uint32_t>(mostCommon) : 0;
+}
+
+std::vector<uint64_t> EdgeTrace::periodicEvents() const {
+    std::vector<uint64_t> events;
+    if (0 == carrierPeriod()) {
+        for (const Edge& edge : edges) {
+            if (edge.level) {
+                events.push_back(edge.cycle * EVENT_SCALE);
+            }
+        }
+        return events;
+    }
+    // duty cycle of every carrier period, upward crossings of 50% interpolated between periods
+    double lastDuty = 0.5;
+    uint64_t lastRising = 0;
+    bool hasLast = false;
+    for (size_t i = 0; i + 2 < edges.size(); i++) {
+        if (!edges[i].level || edges[i + 1].level || !edges[i + 2].level) {
+            continue;
+        }
+        const uint64_t rising = edges[i].cycle;
+        const double duty = static_cast<double>(edges[i + 1].cycle - rising)
+                / static_cast<double>(edges[i + 2].cycle - rising);
+        if (hasLast && lastDuty < 0.5 && duty >= 0.5) {
+            const double at = (0.5 - lastDuty) / (duty - lastDuty);
+            events.push_back(static_cast<uint64_t>((static_cast<double>(lastRising)
+                    + at * static_cast<double>(rising - lastRising)) * EVENT_SCALE));
+        }
+        lastDuty = duty;
+        lastRising = rising;
+        hasLast = true;
+    }
+    return events;
+}
+
+std::vector<TracedNote> EdgeTrace::notes(const double windowSeconds) const {
+    const std::vector<uint64_t> events = periodicEvents();
+    std::vector<TracedNote> result;
+    if (events.empty()) {
+        return result;
+    }
+    const uint64_t window = static_cast<uint64_t>(windowSeconds * cpuFrequency) * EVENT_SCALE;
+
+    struct Run {
+        size_t first;
+
+        size_t last;
+
+        Fit fit;
+
+        size_t windows;
+
+        // events of its windows, frequency and jitter are measured over them
+        size_t windowFirst;
+
+        size_t windowLast;
+    };
+    std::vector<Run> runs;
+    bool isNoteOpen = false;
+
+    size_t first = 0;
+    while (first < events.size()) {
+        const uint64_t windowEnd = events[first] + window;
+        size_t last = first;
+        while (last + 1 < events.size() && events[last + 1] < windowEnd) {
+            last++;
+        }
+        Fit windowFit { 0, 0 };
+        if (!fit(events, first, last, windowFit)) {
+            isNoteOpen = false;
+        } else if (isNoteOpen && windowFit.k == runs.back().fit.k
+                   && fabs(windowFit.period - runs.back().fit.period) <= SAME_NOTE_TOLERANCE * runs.back().fit.period) {
+            runs.back().last = last;
+            runs.back().windows++;
+            runs.back().windowLast = last;
+        } else {
+            runs.push_back(Run { first, last, windowFit, 1, first, last });
+            isNoteOpen = true;
+        }
+        first = last + 1;
+    }
+
+    // whole windows start a note up to a window late, and the window notes change in can pass for
+    // a note of its own (some stride of both notes' edges fits it): notes of two windows or more take
+    // the events around them that keep their period, the earlier note first, and one window notes
+    // keep what is left between them, or are dropped when that is too short to fit
+    auto isInPeriod = [&](const Run& run, const size_t i) {
+        const double distance = static_cast<double>(events[i + run.fit.k] - events[i]);
+        return fabs(distance - run.fit.period) <= PERIOD_TOLERANCE * run.fit.period;
+    };
+    Run* earlier = nullptr;
+    for (Run& run : runs) {
+        if (run.windows < 2) {
+            continue;
+        }
+        size_t floor = 0;
+        if (nullptr != earlier) {
+            while (earlier->last + 1 < run.first && isInPeriod(*earlier, earlier->last + 1 - earlier->fit.k)) {
+                earlier->last++;
+            }
+            floor = earlier->last + 1;
+        }
+        while (run.first > floor && isInPeriod(run, run.first - 1)) {
+            run.first--;
+        }
+        earlier = &run;
+    }
+    if (nullptr != earlier) {
+        while (earlier->last + 1 < events.size() && isInPeriod(*earlier, earlier->last + 1 - earlier->fit.k)) {
+            earlier->last++;
+        }
+    }
+    size_t floor = 0;
+    for (Run& run : runs) {
+        if (run.windows < 2) {
+            run.first = run.first > floor ? run.first : floor;
+        } else {
+            floor = run.last + 1;
+        }
+    }
+    size_t ceiling = events.size();
+    for (size_t r = runs.size(); r-- > 0;) {
+        if (runs[r].windows < 2) {
+            runs[r].last = runs[r].last < ceiling ? runs[r].last : ceiling - 1;
+        } else {
+            ceiling = runs[r].first;
+        }
+    }
+
+    for (const Run& run : runs) {
+        const uint32_t k = run.fit.k;
+        const size_t noteFirst = run.windowFirst > run.first ? run.windowFirst : run.first;
+        const size_t noteLast = run.windowLast < run.last ? run.windowLast : run.last;
+        if (noteLast < noteFirst || noteLast - noteFirst + 1 < MIN_WINDOW_EVENTS || noteLast < noteFirst + 2u * k) {
+            continue;
+        }
+        const size_t periods = (noteLast - noteFirst) / k;
+        const double period = static_cast<double>(events[noteFirst + periods * k] - events[noteFirst])
+                / static_cast<double>(periods);
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+        double sum = 0;
+        double sumSquares = 0;
+        size_t count = 0;
+        for (size_t i = noteFirst; i + 2u * k <= noteLast; i++) {
+            const uint64_t distance = events[i + 2u * k] - events[i];
+            min = distance < min ? distance : min;
+            max = distance > max ? distance : max;
+            sum += static_cast<double>(distance);
+            sumSquares += static_cast<double>(distance) * static_cast<double>(distance);
+            count++;
+        }
+        const double mean = 0 != count ? sum / count : 0;
+        const double variance = 0 != count ? sumSquares / count - mean * mean : 0;
+        result.push_back(TracedNote {
+            events[run.first] / EVENT_SCALE,
+            events[run.last] / EVENT_SCALE,
+            static_cast<double>(cpuFrequency) * EVENT_SCALE / period,
+            k,
+            0 != count ? static_cast<uint32_t>((max - min + EVENT_SCALE / 2u) / EVENT_SCALE) : 0,
+            sqrt(variance > 0 ? variance : 0) / EVENT_SCALE,
+        });
+    }
+    return result;
+}
+
+void nearestNote(const double frequency, char* name, double& cents) {
+    static const char* const NAMES[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    const double midi = 69.0 + 12.0 * log2(frequency / 440.0);
+    const long nearest = lround(midi);
+    cents = (midi - static_cast<double>(nearest)) * 100.0;
+    const long index = ((nearest % 12) + 12) % 12;
+    sprintf(name, "%s%ld", NAMES[index], nearest / 12 - 1);
+}
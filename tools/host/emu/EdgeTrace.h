@@ -0,0 +1,74 @@
+#ifndef HOST_EDGE_TRACE_H
+#define HOST_EDGE_TRACE_H
+
+// PB0 edges at cycle precision, cut into notes with their frequency and edge jitter
+//
+// a note is a run of analysis windows with the same periodicity: the smallest k for which
+// the distance between every rising edge and the k-th next one stays within 5%;
+// bit-banged waveforms have k rising edges per period, a bend alternates two period lengths,
+// so jitter is measured over two periods, where that cancels out
+// a pwm carrier (dds engine) is recognized by its fixed rising edge spacing,
+// then its duty cycles are taken as samples and their upward mid-scale crossings as edges
+
+#include <stdint.h>
+
+#include <vector>
+
+struct TracedNote {
+    uint64_t start;
+
+    uint64_t end;
+
+    double frequency;
+
+    // rising edges (or crossings) per period
+    uint32_t edgesPerPeriod;
+
+    // spread of two-period distances, cycles
+    uint32_t jitterPeakToPeak;
+
+    double jitterRms;
+};
+
+class EdgeTrace {
+public:
+    explicit EdgeTrace(uint32_t cpuFrequency);
+
+    void onLevel(uint64_t cycle, bool level);
+
+    uint64_t edgesCount() const {
+        return edges.size();
+    }
+
+    // pwm carrier period in cycles, 0 when the pin is not a pwm output
+    uint32_t carrierPeriod() const;
+
+    std::vector<TracedNote> notes(double windowSeconds) const;
+
+    struct Edge {
+        uint64_t cycle;
+
+        bool level;
+    };
+
+    const std::vector<Edge>& all() const {
+        return edges;
+    }
+
+private:
+    const uint32_t cpuFrequency;
+
+    std::vector<Edge> edges;
+
+    bool hasLevel = false;
+
+    bool lastLevel = false;
+
+    // times the waveform goes up, in 1/256 cycles
+    std::vector<uint64_t> periodicEvents() const;
+};
+
+// nearest equal tempered note, "A4" and cents off it
+void nearestNote(double frequency, char* name, double& cents);
+
+#endif // HOST_EDGE_TRACE_H
@@ -0,0 +1,114 @@
+#include "ElfImage.h"
+
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+
+namespace {
+    const uint16_t EM_AVR = 83;
+
+    const uint32_t PT_LOAD = 1;
+
+    const uint32_t SHT_SYMTAB = 2;
+
+    const uint32_t SYMBOL_ENTRY_SIZE = 16;
+
+    // ELF32 little endian fields
+    uint32_t read32(const std::vector<uint8_t>& bytes, const size_t offset) {
+        return static_cast<uint32_t>(bytes[offset]) | static_cast<uint32_t>(bytes[offset + 1]) << 8u
+                | static_cast<uint32_t>(bytes[offset + 2]) << 16u | static_cast<uint32_t>(bytes[offset + 3]) << 24u;
+    }
+
+    uint16_t read16(const std::vector<uint8_t>& bytes, const size_t offset) {
+        return static_cast<uint16_t>(bytes[offset] | bytes[offset + 1] << 8u);
+    }
+
+    bool isInside(const std::vector<uint8_t>& bytes, const uint64_t offset, const uint64_t size) {
+        return offset + size <= bytes.size();
+    }
+}
+
+bool ElfImage::load(const char* path, std::string& error) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        error = "can not open";
+        return false;
+    }
+    const std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (file.size() < 52 || 0x7F != file[0] || 'E' != file[1] || 'L' != file[2] || 'F' != file[3]) {
+        error = "not an ELF file";
+        return false;
+    }
+    if (1 != file[4] || 1 != file[5] || EM_AVR != read16(file, 18)) {
+        error = "not a 32-bit little endian AVR image";
+        return false;
+    }
+
+    const uint32_t programHeaders = read32(file, 28);
+    const uint16_t programHeaderSize = read16(file, 42);
+    const uint16_t programHeadersCount = read16(file, 44);
+    flashBytes.clear();
+    for (uint16_t i = 0; i < programHeadersCount; i++) {
+        const uint64_t header = programHeaders + static_cast<uint64_t>(i) * programHeaderSize;
+        if (!isInside(file, header, 32)) {
+            error = "truncated program headers";
+            return false;
+        }
+        const uint32_t offset = read32(file, header + 4);
+        const uint32_t loadAddress = read32(file, header + 12);
+        const uint32_t size = read32(file, header + 16);
+        if (PT_LOAD != read32(file, header) || loadAddress >= DATA_OFFSET || 0 == size) {
+            continue;
+        }
+        if (!isInside(file, offset, size)) {
+            error = "truncated segment";
+            return false;
+        }
+        if (flashBytes.size() < loadAddress + size) {
+            flashBytes.resize(loadAddress + size, 0xFFu);
+        }
+        std::copy(file.begin() + offset, file.begin() + offset + size, flashBytes.begin() + loadAddress);
+    }
+    if (flashBytes.empty()) {
+        error = "no flash segments";
+        return false;
+    }
+
+    const uint32_t sectionHeaders = read32(file, 32);
+    const uint16_t sectionHeaderSize = read16(file, 46);
+    const uint16_t sectionHeadersCount = read16(file, 48);
+    symbols.clear();
+    for (uint16_t i = 0; i < sectionHeadersCount; i++) {
+        const uint64_t header = sectionHeaders + static_cast<uint64_t>(i) * sectionHeaderSize;
+        if (!isInside(file, header, 40) || SHT_SYMTAB != read32(file, header + 4)) {
+            continue;
+        }
+        const uint32_t offset = read32(file, header + 16);
+        const uint32_t size = read32(file, header + 20);
+        const uint64_t namesHeader = sectionHeaders + static_cast<uint64_t>(read32(file, header + 24)) * sectionHeaderSize;
+        if (!isInside(file, offset, size) || !isInside(file, namesHeader, 40)) {
+            continue;
+        }
+        const uint32_t namesOffset = read32(file, namesHeader + 16);
+        const uint32_t namesSize = read32(file, namesHeader + 20);
+        for (uint32_t entry = offset; entry + SYMBOL_ENTRY_SIZE <= offset + size; entry += SYMBOL_ENTRY_SIZE) {
+            const uint32_t name = read32(file, entry);
+            if (0 == name || name >= namesSize || !isInside(file, namesOffset, namesSize)) {
+                continue;
+            }
+            const char* const begin = reinterpret_cast<const char*>(&file[namesOffset + name]);
+            symbols[std::string(begin, strnlen(begin, namesSize - name))] = read32(file, entry + 4);
+        }
+    }
+    return true;
+}
+
+bool ElfImage::symbol(const std::string& name, uint32_t& value) const {
+    const auto it = symbols.find(name);
+    if (it == symbols.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_ELF_IMAGE_H
+#define HOST_ELF_IMAGE_H
+
+// flash contents and symbols of an avr-gcc ELF image
+// loadable segments below the data space offset go to flash at their load address,
+// so .data initializers end up where the startup code copies them from
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+class ElfImage {
+public:
+    // data space addresses appear in symbols with this offset
+    static const uint32_t DATA_OFFSET = 0x800000;
+
+    bool load(const char* path, std::string& error);
+
+    const std::vector<uint8_t>& flash() const {
+        return flashBytes;
+    }
+
+    // value of a symbol, byte address for functions, DATA_OFFSET + address for variables
+    bool symbol(const std::string& name, uint32_t& value) const;
+
+private:
+    std::vector<uint8_t> flashBytes;
+
+    std::map<std::string, uint32_t> symbols;
+};
+
+#endif // HOST_ELF_IMAGE_H
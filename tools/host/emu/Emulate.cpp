@@ -0,0 +1,315 @@
+// runs the firmware image itself on an emulated attiny13a core against the simulated
+// Timer0/PORTB/watchdog, with scripted button presses, and analyses PB0 at cycle precision:
+// frequency and edge jitter of every note, beat timing drift, stack depth
+//
+// usage: ATTiny13Emulate <firmware.elf> [--seconds S] [--press BUTTON@START[:LENGTH]]...
+//                        [--beat S] [--probe SYMBOL] [--max-drift US] [--window S] [--edges out.csv] [--latency]
+//   BUTTON is one of mode, minus, click, plus; START and LENGTH are seconds (LENGTH defaults to 0.1)
+//   beat is the nominal beat length (default 0.125), beats are timed by note starts or by calls to the probe
+//   function (engines put notes together a note ahead, so a probe has to run as a note starts)
+//   max-drift fails the run when the last beat is further than US microseconds off the grid, or beats are too few to time
+//   window is the analysis window notes are cut from (default 0.02)
+//   edges writes every PB0 edge as "cycle,level"
+//   latency prints a histogram of how many cycles every PB0 edge came after the Timer0 overflow
+//   or compare match before it, 0 for edges the timer drives itself
+//
+// exits with 1 when the core faults (unknown opcode, stack overflow, access outside sram),
+// when the stack went down into .data/.bss during the run or when the beats drifted past --max-drift
+
+#include "../sim/HostSim.h"
+#include "../sim/InputScript.h"
+#include "AvrCpu.h"
+#include "EdgeTrace.h"
+#include "ElfImage.h"
+
+#include <avr/io.h>
+
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+namespace {
+    // StackPaint::highWater, only in STACK_PAINT images
+    const char* const STACK_HIGH_WATER_SYMBOL = "_ZN10StackPaint9highWaterE";
+
+    // first sram byte past .data and .bss, the linker script defines it
+    const char* const HEAP_START_SYMBOL = "__heap_start";
+
+    struct Options {
+        const char* elfPath = nullptr;
+
+        double seconds = 5.0;
+
+        double beatSeconds = 0.125;
+
+        double windowSeconds = 0.02;
+
+        const char* probe = nullptr;
+
+        // microseconds, negative when the drift is not checked
+        double maxDrift = -1;
+
+        const char* edgesPath = nullptr;
+
+        bool isLatency = false;
+
+        hostsim::InputScript inputs;
+    };
+
+    const uint32_t LATENCY_HISTOGRAM_ROWS = 32;
+
+    struct EdgeLatencies {
+        uint64_t rising = 0;
+
+        uint64_t falling = 0;
+    };
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13Emulate <firmware.elf> [--seconds S] [--press BUTTON@START[:LENGTH]]...\n");
+        fprintf(stderr, "                       [--beat S] [--probe SYMBOL] [--max-drift US] [--window S] [--edges out.csv] [--latency]\n");
+        fprintf(stderr, "       BUTTON: mode, minus, click, plus\n");
+    }
+
+    bool parseOptions(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (0 == strcmp(arg, "--seconds") && hasValue) {
+                options.seconds = atof(argv[++i]);
+            } else if (0 == strcmp(arg, "--beat") && hasValue) {
+                options.beatSeconds = atof(argv[++i]);
+            } else if (0 == strcmp(arg, "--window") && hasValue) {
+                options.windowSeconds = atof(argv[++i]);
+            } else if (0 == strcmp(arg, "--probe") && hasValue) {
+                options.probe = argv[++i];
+            } else if (0 == strcmp(arg, "--max-drift") && hasValue) {
+                options.maxDrift = atof(argv[++i]);
+            } else if (0 == strcmp(arg, "--edges") && hasValue) {
+                options.edgesPath = argv[++i];
+            } else if (0 == strcmp(arg, "--latency")) {
+                options.isLatency = true;
+            } else if (0 == strcmp(arg, "--press") && hasValue) {
+                if (!options.inputs.addPress(argv[++i])) {
+                    fprintf(stderr, "bad press spec '%s'\n", argv[i]);
+                    return false;
+                }
+            } else if ('-' != arg[0] && nullptr == options.elfPath) {
+                options.elfPath = arg;
+            } else {
+                return false;
+            }
+        }
+        return nullptr != options.elfPath && options.seconds > 0 && options.beatSeconds > 0
+                && options.windowSeconds > 0;
+    }
+
+    double cyclesToMicroseconds(const double cycles) {
+        return cycles * 1e6 / hostsim::CPU_FREQUENCY;
+    }
+
+    void printNotes(const EdgeTrace& trace, const double windowSeconds) {
+        const uint32_t carrier = trace.carrierPeriod();
+        if (0 != carrier) {
+            printf("pwm carrier every %u cycles, notes from its duty cycle\n", carrier);
+        }
+        printf("start s   length ms  frequency Hz  note   cents  edges  jitter p-p/rms cycles\n");
+        for (const TracedNote& note : trace.notes(windowSeconds)) {
+            char name[8];
+            double cents = 0;
+            nearestNote(note.frequency, name, cents);
+            printf("%7.3f  %9.1f  %12.2f  %-5s %+6.1f  %5u  %6u / %.1f\n",
+                   hostsim::cyclesToSeconds(note.start), 1e3 * hostsim::cyclesToSeconds(note.end - note.start),
+                   note.frequency, name, cents, note.edgesPerPeriod, note.jitterPeakToPeak, note.jitterRms);
+        }
+    }
+
+    // every beat against the nominal grid started by the first one, false when there are too few to time,
+    // drift is the last one's in microseconds
+    bool printBeats(const std::vector<uint64_t>& beats, const double beatSeconds, const char* source, double& lastDrift) {
+        if (beats.size() < 2) {
+            printf("beats (%s): too few to time\n", source);
+            return false;
+        }
+        const double nominal = beatSeconds * hostsim::CPU_FREQUENCY;
+        double worstDrift = 0;
+        double drift = 0;
+        double shortest = 1e300;
+        double longest = 0;
+        for (size_t i = 1; i < beats.size(); i++) {
+            const double sinceFirst = static_cast<double>(beats[i] - beats[0]);
+            drift = sinceFirst - round(sinceFirst / nominal) * nominal;
+            worstDrift = fabs(drift) > fabs(worstDrift) ? drift : worstDrift;
+            const double interval = static_cast<double>(beats[i] - beats[i - 1]);
+            shortest = interval < shortest ? interval : shortest;
+            longest = interval > longest ? interval : longest;
+        }
+        const double span = static_cast<double>(beats.back() - beats.front());
+        printf("beats (%s): %zu, interval %.1f..%.1f us of nominal %.1f us, drift %+.1f us (%+.0f ppm), worst %+.1f us\n",
+               source, beats.size(), cyclesToMicroseconds(shortest), cyclesToMicroseconds(longest),
+               cyclesToMicroseconds(nominal), cyclesToMicroseconds(drift), 1e6 * drift / span,
+               cyclesToMicroseconds(worstDrift));
+        lastDrift = cyclesToMicroseconds(drift);
+        return true;
+    }
+
+    // rows of equal width from the lowest latency to the highest
+    void printLatencies(const std::map<uint32_t, EdgeLatencies>& latencies) {
+        if (latencies.empty()) {
+            printf("edge latency: no edges after a timer event\n");
+            return;
+        }
+        const uint32_t lowest = latencies.begin()->first;
+        const uint32_t highest = latencies.rbegin()->first;
+        const uint32_t width = (highest - lowest) / LATENCY_HISTOGRAM_ROWS + 1u;
+        printf("edge latency after timer0 events, cycles: %u..%u\n", lowest, highest);
+        printf("   cycles         rising    falling\n");
+        auto it = latencies.begin();
+        while (it != latencies.end()) {
+            const uint32_t rowStart = lowest + (it->first - lowest) / width * width;
+            EdgeLatencies row;
+            for (; it != latencies.end() && it->first < rowStart + width; ++it) {
+                row.rising += it->second.rising;
+                row.falling += it->second.falling;
+            }
+            if (1u == width) {
+                printf("  %7u      %9llu  %9llu\n", rowStart, static_cast<unsigned long long>(row.rising),
+                       static_cast<unsigned long long>(row.falling));
+            } else {
+                printf("  %7u+%-4u %9llu  %9llu\n", rowStart, width - 1u, static_cast<unsigned long long>(row.rising),
+                       static_cast<unsigned long long>(row.falling));
+            }
+        }
+    }
+
+    bool writeEdges(const char* path, const EdgeTrace& trace) {
+        FILE* const file = fopen(path, "w");
+        if (nullptr == file) {
+            return false;
+        }
+        for (const EdgeTrace::Edge& edge : trace.all()) {
+            fprintf(file, "%llu,%d\n", static_cast<unsigned long long>(edge.cycle), edge.level ? 1 : 0);
+        }
+        return 0 == fclose(file);
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    ElfImage image;
+    std::string error;
+    if (!image.load(options.elfPath, error)) {
+        fprintf(stderr, "%s: %s\n", options.elfPath, error.c_str());
+        return 2;
+    }
+    uint32_t probeAddress = 0;
+    const char* const probe = options.probe;
+    const bool hasProbe = nullptr != probe && image.symbol(probe, probeAddress);
+    if (!hasProbe && nullptr != probe) {
+        fprintf(stderr, "no symbol '%s' in the image\n", options.probe);
+        return 2;
+    }
+    const uint16_t probePc = static_cast<uint16_t>(probeAddress / 2u);
+
+    EdgeTrace trace(hostsim::CPU_FREQUENCY);
+    std::vector<uint64_t> probeHits;
+    AvrCpu cpu(image.flash());
+
+    hostsim::reset();
+    hostsim::setExternalCpu(true);
+    hostsim::scheduleInputs(options.inputs.events());
+    std::map<uint32_t, EdgeLatencies> latencies;
+    hostsim::setPinsListener([&trace, &latencies](const uint64_t cycle, const uint8_t levels) {
+        const bool level = 0 != (levels & _BV(PB0));
+        const uint64_t edgesBefore = trace.edgesCount();
+        trace.onLevel(cycle, level);
+        const uint64_t eventCycle = hostsim::timer0EventCycle();
+        if (trace.edgesCount() != edgesBefore && 0 != eventCycle) {
+            EdgeLatencies& bucket = latencies[static_cast<uint32_t>(cycle - eventCycle)];
+            (level ? bucket.rising : bucket.falling)++;
+        }
+    });
+    const uint64_t stopCycle = hostsim::secondsToCycles(options.seconds);
+    hostsim::stopAt(stopCycle);
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    uint64_t instructions = 0;
+    try {
+        while (true) {
+            const bool isAtProbe = hasProbe && cpu.pc() == probePc;
+            const uint64_t cycle = hostsim::now();
+            const uint32_t cycles = cpu.step();
+            if (isAtProbe && 0 == cpu.lastVector()) {
+                probeHits.push_back(cycle);
+            }
+            instructions++;
+            hostsim::advanceCycles(cycles);
+        }
+    } catch (const hostsim::SimulationStop&) {
+    } catch (const AvrFault& fault) {
+        fprintf(stderr, "fault at 0x%04x after %.6fs: %s\n", 2u * fault.pc,
+                hostsim::cyclesToSeconds(hostsim::now()), fault.message.c_str());
+        return 1;
+    }
+    const auto wallEnd = std::chrono::steady_clock::now();
+
+    const double wallSeconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+    printf("emulated %.3fs in %.3fs (x%.1f), %llu instructions, %llu interrupts, %llu PB0 edges, %.1f%% powered down\n",
+           options.seconds, wallSeconds, wallSeconds > 0 ? options.seconds / wallSeconds : 0.0,
+           static_cast<unsigned long long>(instructions),
+           static_cast<unsigned long long>(hostsim::interruptsServed()),
+           static_cast<unsigned long long>(trace.edgesCount()),
+           100.0 * hostsim::poweredDownCycles() / stopCycle);
+
+    printNotes(trace, options.windowSeconds);
+    double drift = 0;
+    bool isTimed = false;
+    if (hasProbe) {
+        isTimed = printBeats(probeHits, options.beatSeconds, probe, drift);
+    } else {
+        std::vector<uint64_t> starts;
+        for (const TracedNote& note : trace.notes(options.windowSeconds)) {
+            starts.push_back(note.start);
+        }
+        isTimed = printBeats(starts, options.beatSeconds, "note starts", drift);
+    }
+    const bool isDriftOver = options.maxDrift >= 0 && (!isTimed || fabs(drift) > options.maxDrift);
+    if (isDriftOver && isTimed) {
+        fprintf(stderr, "beats drifted %+.1f us, more than %.1f us\n", drift, options.maxDrift);
+    } else if (isDriftOver) {
+        fprintf(stderr, "too few beats to check the drift\n");
+    }
+
+    if (options.isLatency) {
+        printLatencies(latencies);
+    }
+
+    printf("stack: deepest %u bytes (sp reached 0x%02x)", RAMEND - cpu.lowestSp(), cpu.lowestSp());
+    uint32_t highWaterAddress = 0;
+    if (image.symbol(STACK_HIGH_WATER_SYMBOL, highWaterAddress)) {
+        printf(", painted high-water mark %u bytes", cpu.data(static_cast<uint16_t>(highWaterAddress - ElfImage::DATA_OFFSET)));
+    }
+    printf("\n");
+    // a push writes at sp, so the stack overwrote globals once sp went below the last of them
+    uint32_t heapStart = 0;
+    const bool isStackIntoGlobals = image.symbol(HEAP_START_SYMBOL, heapStart)
+                                    && cpu.lowestSp() + 1u < heapStart - ElfImage::DATA_OFFSET;
+    if (isStackIntoGlobals) {
+        fprintf(stderr, "stack ran into .data/.bss, which ends at 0x%02x\n",
+                static_cast<unsigned>(heapStart - ElfImage::DATA_OFFSET));
+    }
+
+    if (nullptr != options.edgesPath && !writeEdges(options.edgesPath, trace)) {
+        fprintf(stderr, "failed to write '%s'\n", options.edgesPath);
+        return 2;
+    }
+    return isStackIntoGlobals || isDriftOver ? 1 : 0;
+}
@@ -0,0 +1,389 @@
+#include "AvrListing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <regex>
+#include <set>
+
+namespace {
+    // attiny13a is an AVRe core without multiplier
+    const std::set<std::string> TWO_CYCLES = {
+        "adiw", "sbiw", "ld", "ldd", "st", "std", "lds", "sts", "push", "pop", "sbi", "cbi",
+    };
+
+    const std::set<std::string> BRANCHES = {
+        "breq", "brne", "brcs", "brcc", "brsh", "brlo", "brmi", "brpl", "brge", "brlt",
+        "brhs", "brhc", "brts", "brtc", "brvs", "brvc", "brie", "brid", "brbs", "brbc",
+    };
+
+    const std::set<std::string> SKIPS = {
+        "cpse", "sbrc", "sbrs", "sbic", "sbis",
+    };
+
+    const std::set<std::string> INDIRECT = {
+        "ijmp", "icall", "eijmp", "eicall",
+    };
+
+    std::string hex(const uint32_t value) {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "0x%x", value);
+        return buffer;
+    }
+}
+
+// -------- LISTING --------
+
+bool AvrListing::load(const char* path) {
+    std::ifstream input(path);
+    if (!input) {
+        return false;
+    }
+    // "00000024 <__vector_7>:"
+    static const std::regex SYMBOL("^([0-9a-f]+) <(.+)>:\\s*$");
+    // "  3a:\t01 f4       \tbrne\t.+0      \t; 0x3c <__vector_7+0x18>"
+    static const std::regex INSTRUCTION("^\\s*([0-9a-f]+):\\t((?:[0-9a-f]{2} )+)\\s*\\t([a-z]+)\\s*([^;]*)(;.*)?$");
+    static const std::regex ADDRESS_COMMENT("^;\\s*0x([0-9a-f]+)");
+    static const std::regex ADDRESS_OPERAND("^0x([0-9a-f]+)");
+
+    std::string line;
+    std::smatch match;
+    while (std::getline(input, line)) {
+        if (std::regex_match(line, match, SYMBOL)) {
+            symbolsByAddress[static_cast<uint32_t>(strtoul(match[1].str().c_str(), nullptr, 16))] = match[2];
+        } else if (std::regex_match(line, match, INSTRUCTION)) {
+            AvrInstruction instruction;
+            instruction.address = static_cast<uint32_t>(strtoul(match[1].str().c_str(), nullptr, 16));
+            instruction.size = static_cast<uint8_t>(match[2].length() / 3u);
+            instruction.mnemonic = match[3];
+            instruction.operands = match[4];
+            while (!instruction.operands.empty() && isspace(instruction.operands.back())) {
+                instruction.operands.pop_back();
+            }
+            const std::string comment = match[5];
+            std::smatch operand;
+            if (std::regex_search(comment, operand, ADDRESS_COMMENT)) {
+                instruction.hasTarget = true;
+                instruction.target = static_cast<uint32_t>(strtoul(operand[1].str().c_str(), nullptr, 16));
+            } else if (std::regex_search(instruction.operands, operand, ADDRESS_OPERAND)) {
+                instruction.hasTarget = true;
+                instruction.target = static_cast<uint32_t>(strtoul(operand[1].str().c_str(), nullptr, 16));
+            }
+            instructions[instruction.address] = instruction;
+        }
+    }
+    return !instructions.empty();
+}
+
+const AvrInstruction* AvrListing::at(const uint32_t address) const {
+    const auto it = instructions.find(address);
+    return it == instructions.end() ? nullptr : &it->second;
+}
+
+std::vector<const AvrInstruction*> AvrListing::range(const uint32_t from, const uint32_t to) const {
+    std::vector<const AvrInstruction*> result;
+    for (auto it = instructions.lower_bound(from); it != instructions.end() && it->first < to; ++it) {
+        result.push_back(&it->second);
+    }
+    return result;
+}
+
+bool AvrListing::symbolAddress(const std::string& name, uint32_t& address) const {
+    for (const auto& symbol : symbolsByAddress) {
+        if (symbol.second == name) {
+            address = symbol.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<uint32_t> AvrListing::symbolsContaining(const std::string& part) const {
+    std::vector<uint32_t> result;
+    for (const auto& symbol : symbolsByAddress) {
+        if (std::string::npos != symbol.second.find(part)) {
+            result.push_back(symbol.first);
+        }
+    }
+    return result;
+}
+
+std::string AvrListing::describe(const uint32_t address) const {
+    auto it = symbolsByAddress.upper_bound(address);
+    if (it == symbolsByAddress.begin()) {
+        return hex(address);
+    }
+    --it;
+    const uint32_t offset = address - it->first;
+    return hex(address) + " <" + it->second + (0 == offset ? "" : "+" + hex(offset)) + ">";
+}
+
+// ----------------
+
+// -------- WORST CASE PATH --------
+
+WorstCasePath::WorstCasePath(const AvrListing& listing, const uint32_t loopBound)
+        : listing(listing), loopBound(loopBound) {
+}
+
+bool WorstCasePath::fail(const std::string& message) {
+    if (errorMessage.empty()) {
+        errorMessage = message;
+    }
+    return false;
+}
+
+bool WorstCasePath::edges(const AvrInstruction& instruction, std::vector<Edge>& result) {
+    const std::string& m = instruction.mnemonic;
+    const uint32_t next = instruction.address + instruction.size;
+    result.clear();
+    if (INDIRECT.count(m)) {
+        if (indirectTargets.empty() || ("icall" != m && "ijmp" != m)) {
+            return fail("indirect jump or call at " + listing.describe(instruction.address));
+        }
+        // ijmp is a tail call, the target returns for us
+        for (const uint32_t target : indirectTargets) {
+            result.push_back("icall" == m ? Edge { next, 3, false, true, target } : Edge { 0, 2, true, true, target });
+        }
+        return true;
+    }
+    if ("ret" == m || "reti" == m) {
+        result.push_back(Edge { 0, 4, true, false, 0 });
+        return true;
+    }
+    const bool isJump = "rjmp" == m || "jmp" == m;
+    const bool isCall = "rcall" == m || "call" == m;
+    if ((isJump || isCall || BRANCHES.count(m)) && !instruction.hasTarget) {
+        return fail("no target for " + m + " at " + listing.describe(instruction.address));
+    }
+    if (isJump) {
+        result.push_back(Edge { instruction.target, "rjmp" == m ? 2u : 3u, false, false, 0 });
+    } else if (isCall) {
+        result.push_back(Edge { next, "rcall" == m ? 3u : 4u, false, true, instruction.target });
+    } else if (BRANCHES.count(m)) {
+        result.push_back(Edge { next, 1, false, false, 0 });
+        result.push_back(Edge { instruction.target, 2, false, false, 0 });
+    } else if (SKIPS.count(m)) {
+        const AvrInstruction* const skipped = listing.at(next);
+        if (nullptr == skipped) {
+            return fail("skip over unknown code at " + listing.describe(instruction.address));
+        }
+        result.push_back(Edge { next, 1, false, false, 0 });
+        result.push_back(Edge { next + skipped->size, 1u + skipped->size / 2u, false, false, 0 });
+    } else if ("lpm" == m) {
+        result.push_back(Edge { next, 3, false, false, 0 });
+    } else {
+        result.push_back(Edge { next, TWO_CYCLES.count(m) ? 2u : 1u, false, false, 0 });
+    }
+    return true;
+}
+
+bool WorstCasePath::cycles(const uint32_t entry, uint32_t& result) {
+    return function(entry, result);
+}
+
+bool WorstCasePath::interruptsOff(const uint32_t cli, uint32_t& result) {
+    const AvrInstruction* const instruction = listing.at(cli);
+    if (nullptr == instruction || "cli" != instruction->mnemonic) {
+        return fail("no cli at " + listing.describe(cli));
+    }
+    std::map<uint32_t, int64_t> memo;
+    return longestToSei(cli + instruction->size, memo, result);
+}
+
+bool WorstCasePath::function(const uint32_t entry, uint32_t& result) {
+    Mark& mark = functionMarks[entry];
+    if (MarkActive == mark) {
+        return fail("recursion through " + listing.describe(entry));
+    }
+    std::map<uint32_t, uint32_t>& values = worst[entry];
+    if (MarkNone == mark) {
+        mark = MarkActive;
+        std::map<uint32_t, Mark> marks;
+        std::multimap<uint32_t, uint32_t> backEdges;
+        if (!visit(entry, values, marks, backEdges)) {
+            return false;
+        }
+        functionMarks[entry] = MarkDone;
+    }
+    result = values[entry];
+    return true;
+}
+
+bool WorstCasePath::visit(const uint32_t address, std::map<uint32_t, uint32_t>& values,
+                          std::map<uint32_t, Mark>& marks, std::multimap<uint32_t, uint32_t>& backEdges) {
+    const AvrInstruction* const instruction = listing.at(address);
+    if (nullptr == instruction) {
+        return fail("path runs into unknown code at " + listing.describe(address));
+    }
+    marks[address] = MarkActive;
+    std::vector<Edge> out;
+    if (!edges(*instruction, out)) {
+        return false;
+    }
+    uint32_t best = 0;
+    for (const Edge& edge : out) {
+        uint32_t cost = edge.cost;
+        if (edge.isCall) {
+            uint32_t callee = 0;
+            if (!function(edge.callee, callee)) {
+                return false;
+            }
+            cost += callee;
+        }
+        if (!edge.isExit) {
+            const Mark toMark = marks[edge.to];
+            if (MarkActive == toMark) {
+                // loop, its iterations are added once the header is done
+                backEdges.emplace(edge.to, address);
+                continue;
+            }
+            if (MarkNone == toMark && !visit(edge.to, values, marks, backEdges)) {
+                return false;
+            }
+            cost += values[edge.to];
+        }
+        best = cost > best ? cost : best;
+    }
+
+    const auto loopsHere = backEdges.equal_range(address);
+    uint32_t longestIteration = 0;
+    for (auto it = loopsHere.first; it != loopsHere.second; ++it) {
+        // header -> ... -> latch, then the latch instruction back to the header
+        std::map<uint32_t, int64_t> memo;
+        int64_t toLatch = 0;
+        if (!longestTo(address, it->second, memo, toLatch)) {
+            return false;
+        }
+        std::vector<Edge> latchEdges;
+        if (!edges(*listing.at(it->second), latchEdges)) {
+            return false;
+        }
+        uint32_t latchCost = 0;
+        for (const Edge& edge : latchEdges) {
+            if (!edge.isExit && edge.to == address) {
+                latchCost = edge.cost > latchCost ? edge.cost : latchCost;
+            }
+        }
+        const uint32_t iteration = static_cast<uint32_t>(toLatch) + latchCost;
+        longestIteration = iteration > longestIteration ? iteration : longestIteration;
+    }
+    if (loopsHere.first != loopsHere.second) {
+        loopHeaders.push_back(address);
+        best += loopBound * longestIteration;
+        backEdges.erase(address);
+    }
+
+    values[address] = best;
+    marks[address] = MarkDone;
+    return true;
+}
+
+// longest loop free path from one instruction to the start of another, latch instruction excluded
+bool WorstCasePath::longestTo(const uint32_t from, const uint32_t to, std::map<uint32_t, int64_t>& memo,
+                              int64_t& result) {
+    if (from == to) {
+        result = 0;
+        return true;
+    }
+    const auto known = memo.find(from);
+    if (known != memo.end()) {
+        result = known->second;
+        return true;
+    }
+    // marks the node as in progress, edges back to it do not count
+    memo[from] = -1;
+    std::vector<Edge> out;
+    if (!edges(*listing.at(from), out)) {
+        return false;
+    }
+    int64_t best = -1;
+    for (const Edge& edge : out) {
+        if (edge.isExit || nullptr == listing.at(edge.to)) {
+            continue;
+        }
+        int64_t rest = 0;
+        if (!longestTo(edge.to, to, memo, rest)) {
+            return false;
+        }
+        if (rest < 0) {
+            continue;
+        }
+        int64_t cost = edge.cost + rest;
+        if (edge.isCall) {
+            uint32_t callee = 0;
+            if (!function(edge.callee, callee)) {
+                return false;
+            }
+            cost += callee;
+        }
+        best = cost > best ? cost : best;
+    }
+    memo[from] = best;
+    result = best;
+    return true;
+}
+
+// longest path from an instruction through the next sei and the instruction after it
+bool WorstCasePath::longestToSei(const uint32_t from, std::map<uint32_t, int64_t>& memo, uint32_t& result) {
+    const auto known = memo.find(from);
+    if (known != memo.end()) {
+        if (known->second < 0) {
+            return fail("loop with interrupts off at " + listing.describe(from));
+        }
+        result = static_cast<uint32_t>(known->second);
+        return true;
+    }
+    const AvrInstruction* const instruction = listing.at(from);
+    if (nullptr == instruction) {
+        return fail("interrupts off run into unknown code at " + listing.describe(from));
+    }
+    if ("reti" == instruction->mnemonic) {
+        result = 4;
+        memo[from] = result;
+        return true;
+    }
+    if ("ret" == instruction->mnemonic || INDIRECT.count(instruction->mnemonic)) {
+        return fail("leaves with interrupts off at " + listing.describe(from));
+    }
+    memo[from] = -1;
+    std::vector<Edge> out;
+    if (!edges(*instruction, out)) {
+        return false;
+    }
+    uint32_t best = 0;
+    for (const Edge& edge : out) {
+        uint32_t cost = edge.cost;
+        if ("sei" == instruction->mnemonic) {
+            // the next instruction runs, a call there runs its callee with interrupts on
+            std::vector<Edge> after;
+            const AvrInstruction* const next = listing.at(edge.to);
+            if (nullptr == next || !edges(*next, after)) {
+                return fail("no instruction after sei at " + listing.describe(from));
+            }
+            for (const Edge& last : after) {
+                cost = edge.cost + last.cost > cost ? edge.cost + last.cost : cost;
+            }
+        } else {
+            if (edge.isCall) {
+                uint32_t callee = 0;
+                if (!function(edge.callee, callee)) {
+                    return false;
+                }
+                cost += callee;
+            }
+            uint32_t rest = 0;
+            if (!longestToSei(edge.to, memo, rest)) {
+                return false;
+            }
+            cost += rest;
+        }
+        best = cost > best ? cost : best;
+    }
+    memo[from] = best;
+    result = best;
+    return true;
+}
+
+// ----------------
@@ -0,0 +1,133 @@
+#ifndef HOST_AVR_LISTING_H
+#define HOST_AVR_LISTING_H
+
+// avr-objdump -d / -S listing of an attiny13a image, read back into instructions
+// with their cycle counts, for worst case analysis of interrupt handlers and stack depth
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct AvrInstruction {
+    uint32_t address = 0;
+
+    uint8_t size = 0;
+
+    std::string mnemonic;
+
+    std::string operands;
+
+    // jump, branch or call target, from objdump "; 0x..." comment or jmp/call operand
+    bool hasTarget = false;
+
+    uint32_t target = 0;
+};
+
+class AvrListing {
+public:
+    bool load(const char* path);
+
+    const AvrInstruction* at(uint32_t address) const;
+
+    // instructions in [from, to), in address order
+    std::vector<const AvrInstruction*> range(uint32_t from, uint32_t to) const;
+
+    // start address of symbol, false if the listing has no such symbol
+    bool symbolAddress(const std::string& name, uint32_t& address) const;
+
+    // start addresses of symbols whose name contains part
+    std::vector<uint32_t> symbolsContaining(const std::string& part) const;
+
+    // symbol the address belongs to, with offset, for messages
+    std::string describe(uint32_t address) const;
+
+    const std::map<uint32_t, std::string>& symbols() const {
+        return symbolsByAddress;
+    }
+
+private:
+    std::map<uint32_t, AvrInstruction> instructions;
+
+    std::map<uint32_t, std::string> symbolsByAddress;
+};
+
+// worst case cycles of a path from an address until ret/reti,
+// calls add the worst case of their callee, every loop is assumed to run at most loopBound times
+class WorstCasePath {
+public:
+    WorstCasePath(const AvrListing& listing, uint32_t loopBound);
+
+    // icall and ijmp may go to any of these functions, without them indirect jumps can not be bounded
+    void setIndirectTargets(const std::vector<uint32_t>& targets) {
+        indirectTargets = targets;
+    }
+
+    // false if the path can not be bounded: indirect jumps, recursion, unknown code
+    bool cycles(uint32_t entry, uint32_t& result);
+
+    // worst case cycles interrupts stay off after the cli at the address: up to the sei
+    // and the instruction after it, which runs before any pending interrupt is served
+    bool interruptsOff(uint32_t cli, uint32_t& result);
+
+    const std::string& error() const {
+        return errorMessage;
+    }
+
+    // headers of loops met so far, they are worth a look whether loopBound holds for them
+    const std::vector<uint32_t>& loops() const {
+        return loopHeaders;
+    }
+
+private:
+    struct Edge {
+        uint32_t to;
+
+        uint32_t cost;
+
+        // path ends after the instruction
+        bool isExit;
+
+        // callee to add to the cost
+        bool isCall;
+
+        uint32_t callee;
+    };
+
+    enum Mark {
+        MarkNone,
+        MarkActive,
+        MarkDone,
+    };
+
+    const AvrListing& listing;
+
+    const uint32_t loopBound;
+
+    std::vector<uint32_t> indirectTargets;
+
+    std::string errorMessage;
+
+    std::vector<uint32_t> loopHeaders;
+
+    // per function entry: worst case from every address already analyzed
+    std::map<uint32_t, std::map<uint32_t, uint32_t>> worst;
+
+    std::map<uint32_t, Mark> functionMarks;
+
+    bool edges(const AvrInstruction& instruction, std::vector<Edge>& result);
+
+    bool function(uint32_t entry, uint32_t& result);
+
+    bool visit(uint32_t address, std::map<uint32_t, uint32_t>& values, std::map<uint32_t, Mark>& marks,
+               std::multimap<uint32_t, uint32_t>& backEdges);
+
+    bool longestTo(uint32_t from, uint32_t to, std::map<uint32_t, int64_t>& memo, int64_t& result);
+
+    bool longestToSei(uint32_t from, std::map<uint32_t, int64_t>& memo, uint32_t& result);
+
+    bool fail(const std::string& message);
+};
+
+#endif // HOST_AVR_LISTING_H
@@ -0,0 +1,162 @@
+// interrupt handlers worst case cycles, from avr-objdump listing of the firmware image,
+// checked against the interrupt budget of the waveform engine (WaveformGen::interruptBudget())
+// the host tools are configured with
+//
+// usage: ATTiny13IsrBudget <listing> [--loop-bound N] [--indirect PART]...
+//   listing is `avr-objdump -d` or `-S` output, N is the most iterations assumed for any loop (default 8)
+//   indirect calls and jumps may go to every function with PART in its (mangled) name
+//
+// the budgeted vector has to be served within its budget even when it comes
+// right after another handler has started: response + that whole handler + its own worst case,
+// and after the longest stretch the main loop runs with interrupts off (cli until sei)
+// exits with 1 when it does not fit or a handler can not be bounded
+
+#include "AvrListing.h"
+
+#include <avr/io.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+namespace WaveformGen {
+    struct InterruptBudget {
+        uint8_t vectorNumber;
+
+        uint32_t cycles;
+    };
+
+    InterruptBudget interruptBudget();
+}
+
+namespace {
+    // interrupt response (pc push, jump to vector) plus rjmp in the vector table
+    const uint32_t INTERRUPT_ENTRY_CYCLES = 4u + 2u;
+
+    // extra response time when the interrupt wakes the cpu from sleep
+    const uint32_t SLEEP_WAKE_CYCLES = 4u;
+
+    const uint32_t DEFAULT_LOOP_BOUND = 8u;
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13IsrBudget <listing> [--loop-bound N] [--indirect PART]...\n");
+    }
+
+    std::string vectorSymbol(const uint8_t vectorNumber) {
+        return "__vector_" + std::to_string(vectorNumber);
+    }
+
+    // symbol the address belongs to
+    std::string symbolOf(const AvrListing& listing, const uint32_t address) {
+        auto it = listing.symbols().upper_bound(address);
+        return it == listing.symbols().begin() ? std::string() : (--it)->second;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const char* listingPath = nullptr;
+    uint32_t loopBound = DEFAULT_LOOP_BOUND;
+    std::vector<std::string> indirectParts;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--loop-bound") && i + 1 < argc) {
+            loopBound = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (0 == strcmp(argv[i], "--indirect") && i + 1 < argc) {
+            indirectParts.push_back(argv[++i]);
+        } else if ('-' != argv[i][0] && nullptr == listingPath) {
+            listingPath = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (nullptr == listingPath) {
+        usage();
+        return 2;
+    }
+
+    AvrListing listing;
+    if (!listing.load(listingPath)) {
+        fprintf(stderr, "no instructions in '%s'\n", listingPath);
+        return 2;
+    }
+
+    const WaveformGen::InterruptBudget budget = WaveformGen::interruptBudget();
+    WorstCasePath path(listing, loopBound);
+    std::vector<uint32_t> indirectTargets;
+    for (const std::string& part : indirectParts) {
+        const std::vector<uint32_t> targets = listing.symbolsContaining(part);
+        indirectTargets.insert(indirectTargets.end(), targets.begin(), targets.end());
+    }
+    path.setIndirectTargets(indirectTargets);
+    // a call through a function table costs icall (3) or ijmp (2) and the table read on top of these
+    for (const uint32_t target : indirectTargets) {
+        uint32_t cycles = 0;
+        if (path.cycles(target, cycles)) {
+            printf("indirect target %s: %u cycles\n", listing.describe(target).c_str(), cycles);
+        }
+    }
+    bool isBounded = true;
+    bool hasBudgeted = false;
+    uint32_t budgetedCycles = 0;
+    uint32_t longestOther = 0;
+
+    printf("vector          worst cycles\n");
+    for (uint8_t vectorNumber = 1; vectorNumber < _VECTORS_SIZE / 2; vectorNumber++) {
+        const std::string symbol = vectorSymbol(vectorNumber);
+        uint32_t entry = 0;
+        if (!listing.symbolAddress(symbol, entry)) {
+            continue;
+        }
+        uint32_t cycles = 0;
+        if (!path.cycles(entry, cycles)) {
+            printf("%-15s unbounded: %s\n", symbol.c_str(), path.error().c_str());
+            isBounded = false;
+            continue;
+        }
+        printf("%-15s %u\n", symbol.c_str(), cycles);
+        if (vectorNumber == budget.vectorNumber) {
+            hasBudgeted = true;
+            budgetedCycles = cycles;
+        } else {
+            const uint32_t other = INTERRUPT_ENTRY_CYCLES + cycles;
+            longestOther = other > longestOther ? other : longestOther;
+        }
+    }
+    // handlers run with interrupts off anyway, _exit turns them off for good
+    uint32_t longestWindow = 0;
+    for (const AvrInstruction* const instruction : listing.range(0, UINT32_MAX)) {
+        const std::string symbol = symbolOf(listing, instruction->address);
+        if ("cli" != instruction->mnemonic || 0 == symbol.rfind("__vector_", 0) || "_exit" == symbol) {
+            continue;
+        }
+        uint32_t cycles = 0;
+        if (!path.interruptsOff(instruction->address, cycles)) {
+            printf("cli at %s unbounded: %s\n", listing.describe(instruction->address).c_str(), path.error().c_str());
+            isBounded = false;
+            continue;
+        }
+        printf("cli at %s: interrupts off %u cycles\n", listing.describe(instruction->address).c_str(), cycles);
+        longestWindow = cycles > longestWindow ? cycles : longestWindow;
+    }
+    for (const uint32_t header : path.loops()) {
+        printf("loop at %s assumed to run at most %u times\n", listing.describe(header).c_str(), loopBound);
+    }
+
+    if (!isBounded) {
+        printf("FAIL: some handlers or interrupts off windows can not be bounded\n");
+        return 1;
+    }
+    if (!hasBudgeted) {
+        printf("FAIL: no %s in the listing\n", vectorSymbol(budget.vectorNumber).c_str());
+        return 1;
+    }
+    const uint32_t total = SLEEP_WAKE_CYCLES + INTERRUPT_ENTRY_CYCLES + budgetedCycles + longestOther + longestWindow;
+    const bool isWithin = total <= budget.cycles;
+    printf("%s: %s worst %u + entry %u + longest other handler %u + longest cli window %u = %u of %u cycles budget\n",
+           isWithin ? "OK" : "FAIL", vectorSymbol(budget.vectorNumber).c_str(), budgetedCycles,
+           SLEEP_WAKE_CYCLES + INTERRUPT_ENTRY_CYCLES, longestOther, longestWindow, total, budget.cycles);
+    return isWithin ? 0 : 1;
+}
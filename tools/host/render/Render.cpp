@@ -0,0 +1,110 @@
+// offline renderer: runs firmware main() against simulated Timer0/PORTB
+// and writes PB0 (blinkerPin) as 16-bit mono wav
+//
+// usage: ATTiny13Render <out.wav> [--seconds S] [--rate HZ] [--press BUTTON@START[:LENGTH]]...
+//   BUTTON is one of mode, minus, click, plus; START and LENGTH are seconds (LENGTH defaults to 0.1)
+//
+// prints a summary line with a hash of the pcm data, so sound regressions can be caught
+// by comparing it between builds
+
+#include "../sim/HostSim.h"
+#include "../sim/InputScript.h"
+#include "WavWriter.h"
+
+#include <avr/io.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+int firmware_main();
+
+namespace {
+    struct Options {
+        const char* outputPath = nullptr;
+
+        double seconds = 5.0;
+
+        uint32_t sampleRate = 44100;
+
+        hostsim::InputScript inputs;
+    };
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13Render <out.wav> [--seconds S] [--rate HZ] [--press BUTTON@START[:LENGTH]]...\n");
+        fprintf(stderr, "       BUTTON: mode, minus, click, plus\n");
+    }
+
+    bool parseOptions(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (0 == strcmp(arg, "--seconds") && hasValue) {
+                options.seconds = atof(argv[++i]);
+            } else if (0 == strcmp(arg, "--rate") && hasValue) {
+                options.sampleRate = static_cast<uint32_t>(atoi(argv[++i]));
+            } else if (0 == strcmp(arg, "--press") && hasValue) {
+                if (!options.inputs.addPress(argv[++i])) {
+                    fprintf(stderr, "bad press spec '%s'\n", argv[i]);
+                    return false;
+                }
+            } else if ('-' != arg[0] && nullptr == options.outputPath) {
+                options.outputPath = arg;
+            } else {
+                return false;
+            }
+        }
+        return nullptr != options.outputPath && options.seconds > 0 && options.sampleRate > 0;
+    }
+
+    uint32_t fnv1a(const std::vector<int16_t>& pcm) {
+        uint32_t hash = 2166136261u;
+        for (const int16_t sample : pcm) {
+            const uint16_t bits = static_cast<uint16_t>(sample);
+            hash = (hash ^ (bits & 0xFFu)) * 16777619u;
+            hash = (hash ^ (bits >> 8u)) * 16777619u;
+        }
+        return hash;
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    PinToPcm pcm(hostsim::CPU_FREQUENCY, options.sampleRate);
+
+    hostsim::reset();
+    hostsim::scheduleInputs(options.inputs.events());
+    hostsim::setPinsListener([&pcm](const uint64_t cycle, const uint8_t levels) {
+        pcm.onLevel(cycle, 0 != (levels & _BV(PB0)));
+    });
+    const uint64_t stopCycle = hostsim::secondsToCycles(options.seconds);
+    hostsim::stopAt(stopCycle);
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    try {
+        firmware_main();
+        fprintf(stderr, "firmware main() returned\n");
+    } catch (const hostsim::SimulationStop&) {
+    }
+    const auto wallEnd = std::chrono::steady_clock::now();
+    pcm.finish(stopCycle);
+
+    if (!writeWav(options.outputPath, options.sampleRate, pcm.pcm())) {
+        fprintf(stderr, "failed to write '%s'\n", options.outputPath);
+        return 1;
+    }
+
+    const double wallSeconds = std::chrono::duration<double>(wallEnd - wallStart).count();
+    printf("rendered %.3fs in %.3fs (x%.0f), %llu PB0 edges, %zu samples, pcm fnv1a %08x, %.1f%% powered down\n",
+           options.seconds, wallSeconds, wallSeconds > 0 ? options.seconds / wallSeconds : 0.0,
+           static_cast<unsigned long long>(pcm.edgesCount()), pcm.pcm().size(), fnv1a(pcm.pcm()),
+           100.0 * hostsim::poweredDownCycles() / stopCycle);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "WavWriter.h"
+
+namespace {
+    const double PCM_AMPLITUDE = 0.5 * 32767.0;
+
+    const double DC_BLOCKER_POLE = 0.995;
+
+    void writeLE16(FILE* file, const uint16_t value) {
+        const uint8_t bytes[2] = {
+            static_cast<uint8_t>(value),
+            static_cast<uint8_t>(value >> 8u),
+        };
+        fwrite(bytes, 1, sizeof(bytes), file);
+    }
+
+    void writeLE32(FILE* file, const uint32_t value) {
+        writeLE16(file, static_cast<uint16_t>(value));
+        writeLE16(file, static_cast<uint16_t>(value >> 16u));
+    }
+}
+
+PinToPcm::PinToPcm(const uint32_t cpuFrequency, const uint32_t sampleRate)
+        : cyclesPerSample(static_cast<double>(cpuFrequency) / sampleRate) {
+}
+
+void PinToPcm::onLevel(const uint64_t cycle, const bool level) {
+    advanceTo(cycle);
+    if (level != lastLevel) {
+        edges++;
+    }
+    lastLevel = level;
+}
+
+void PinToPcm::finish(const uint64_t cycle) {
+    advanceTo(cycle);
+}
+
+void PinToPcm::advanceTo(const uint64_t cycle) {
+    double position = static_cast<double>(lastCycle);
+    const double target = static_cast<double>(cycle);
+    while (position < target) {
+        const double sampleEnd = sampleStart + cyclesPerSample;
+        const double spanEnd = target < sampleEnd ? target : sampleEnd;
+        if (lastLevel) {
+            highCycles += spanEnd - position;
+        }
+        position = spanEnd;
+        if (position >= sampleEnd) {
+            emitSample();
+        }
+    }
+    lastCycle = cycle;
+}
+
+void PinToPcm::emitSample() {
+    const double level = highCycles / cyclesPerSample;
+    const double dcBlocked = level - dcPrevIn + DC_BLOCKER_POLE * dcPrevOut;
+    dcPrevIn = level;
+    dcPrevOut = dcBlocked;
+
+    double value = dcBlocked * 2.0 * PCM_AMPLITUDE;
+    value = value > 32767.0 ? 32767.0 : (value < -32768.0 ? -32768.0 : value);
+    samples.push_back(static_cast<int16_t>(value));
+
+    sampleStart += cyclesPerSample;
+    highCycles = 0;
+}
+
+bool writeWav(const char* path, const uint32_t sampleRate, const std::vector<int16_t>& pcm) {
+    FILE* file = fopen(path, "wb");
+    if (nullptr == file) {
+        return false;
+    }
+    const uint32_t dataSize = static_cast<uint32_t>(pcm.size() * sizeof(int16_t));
+
+    fwrite("RIFF", 1, 4, file);
+    writeLE32(file, 36u + dataSize);
+    fwrite("WAVE", 1, 4, file);
+
+    fwrite("fmt ", 1, 4, file);
+    writeLE32(file, 16u);               // chunk size
+    writeLE16(file, 1u);                // pcm
+    writeLE16(file, 1u);                // mono
+    writeLE32(file, sampleRate);
+    writeLE32(file, sampleRate * 2u);   // byte rate
+    writeLE16(file, 2u);                // block align
+    writeLE16(file, 16u);               // bits per sample
+
+    fwrite("data", 1, 4, file);
+    writeLE32(file, dataSize);
+    for (const int16_t sample : pcm) {
+        writeLE16(file, static_cast<uint16_t>(sample));
+    }
+
+    return 0 == fclose(file);
+}
@@ -0,0 +1,54 @@
+#ifndef HOST_WAV_WRITER_H
+#define HOST_WAV_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+// integrates a 1-bit pin level over simulated cpu cycles into 16-bit mono pcm,
+// then passes it through a dc blocker standing in for the speaker coupling capacitor
+class PinToPcm {
+private:
+    const double cyclesPerSample;
+
+    std::vector<int16_t> samples;
+
+    uint64_t lastCycle = 0;
+
+    bool lastLevel = false;
+
+    double sampleStart = 0;
+
+    double highCycles = 0;
+
+    double dcPrevIn = 0;
+
+    double dcPrevOut = 0;
+
+    uint64_t edges = 0;
+
+public:
+    PinToPcm(uint32_t cpuFrequency, uint32_t sampleRate);
+
+    void onLevel(uint64_t cycle, bool level);
+
+    void finish(uint64_t cycle);
+
+    const std::vector<int16_t>& pcm() const {
+        return samples;
+    }
+
+    uint64_t edgesCount() const {
+        return edges;
+    }
+
+private:
+    void advanceTo(uint64_t cycle);
+
+    void emitSample();
+};
+
+bool writeWav(const char* path, uint32_t sampleRate, const std::vector<int16_t>& pcm);
+
+#endif // HOST_WAV_WRITER_H
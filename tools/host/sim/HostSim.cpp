@@ -0,0 +1,663 @@
+#include "HostSim.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include <stdio.h>
+
+namespace hostsim {
+    namespace {
+        const uint8_t REGISTERS_COUNT = RAMSTART;
+
+        const uint8_t PORTB_PINS_MASK = 0b111111u;
+
+        enum TimerMode {
+            TimerNormal = 0,
+            TimerPhaseCorrect = 1,
+            TimerCTC = 2,
+            TimerFastPWM = 3,
+            TimerPhaseCorrectTopA = 5,
+            TimerFastPWMTopA = 7,
+        };
+
+        struct Timer0State {
+            uint8_t counter = 0;
+
+            bool countingDown = false;
+
+            // compare registers actually used for matching,
+            // pwm modes update them from OCR0x at TOP/BOTTOM
+            uint8_t compareA = 0;
+
+            uint8_t compareB = 0;
+
+            bool outputA = false;
+
+            bool outputB = false;
+
+            uint8_t flags = 0;
+
+            // latest tick that raised an enabled flag or drove a connected output
+            uint64_t eventCycle = 0;
+        };
+
+        struct SimState {
+            uint8_t registers[REGISTERS_COUNT] = {};
+
+            Timer0State timer0;
+
+            uint64_t now = 0;
+
+            uint64_t stopCycle = UINT64_MAX;
+
+            std::vector<InputEvent> inputs;
+
+            size_t nextInput = 0;
+
+            uint8_t groundedPins = 0;
+
+            uint8_t lastPinLevels = 0xFFu;
+
+            PinsListener pinsListener;
+
+            uint64_t interruptsServed = 0;
+
+            // cycle the watchdog counter started counting from
+            uint64_t watchdogStart = 0;
+
+            // power-down sleep halts Timer0 clock
+            bool isPoweredDown = false;
+
+            uint64_t poweredDownCycles = 0;
+
+            bool isExternalCpu = false;
+
+            uint8_t eeprom[EEPROM_SIZE] = {};
+        };
+
+        SimState state;
+
+        // handlers register from static initializers, possibly before reset() is ever called
+        VectorHandler* vectors() {
+            static VectorHandler table[_VECTORS_SIZE / 2] = {};
+            return table;
+        }
+
+        uint8_t& reg(const uint8_t address) {
+            return state.registers[address];
+        }
+
+        bool isBitSet(const uint8_t address, const uint8_t bit) {
+            return 0 != (reg(address) & _BV(bit));
+        }
+
+        uint8_t timerMode() {
+            const uint8_t wgmLow = reg(TCCR0A) & (_BV(WGM01) | _BV(WGM00));
+            const uint8_t wgmHigh = isBitSet(TCCR0B, WGM02) ? 0b100u : 0u;
+            return wgmHigh | wgmLow;
+        }
+
+        bool isPWMMode(const uint8_t mode) {
+            return mode != TimerNormal && mode != TimerCTC;
+        }
+
+        uint32_t timerPrescaler() {
+            if (state.isPoweredDown) {
+                return 0;
+            }
+            switch (reg(TCCR0B) & (_BV(CS02) | _BV(CS01) | _BV(CS00))) {
+                case 1: return 1;
+                case 2: return 8;
+                case 3: return 64;
+                case 4: return 256;
+                case 5: return 1024;
+                // stopped or clocked from T0 pin, which nothing drives here
+                default: return 0;
+            }
+        }
+
+        uint8_t timerTop(const uint8_t mode) {
+            switch (mode) {
+                case TimerCTC:
+                case TimerPhaseCorrectTopA:
+                case TimerFastPWMTopA:
+                    return reg(OCR0A);
+                default:
+                    return 0xFFu;
+            }
+        }
+
+        uint8_t compareOutputModeA() {
+            return static_cast<uint8_t>(reg(TCCR0A) >> COM0A0) & 0b11u;
+        }
+
+        uint8_t compareOutputModeB() {
+            return static_cast<uint8_t>(reg(TCCR0A) >> COM0B0) & 0b11u;
+        }
+
+        bool isOutputConnected(const uint8_t com, const bool isChannelA) {
+            if (0 == com) {
+                return false;
+            }
+            if (1 == com && isPWMMode(timerMode())) {
+                // toggle in pwm modes is only available on OC0A with WGM02
+                return isChannelA && isBitSet(TCCR0B, WGM02);
+            }
+            return true;
+        }
+
+        void applyCompareMatch(const uint8_t com, bool& output) {
+            const uint8_t mode = timerMode();
+            switch (com) {
+                case 1:
+                    output = !output;
+                    break;
+                case 2:
+                    if (mode == TimerPhaseCorrect || mode == TimerPhaseCorrectTopA) {
+                        output = state.timer0.countingDown;
+                    } else {
+                        output = false;
+                    }
+                    break;
+                case 3:
+                    if (mode == TimerPhaseCorrect || mode == TimerPhaseCorrectTopA) {
+                        output = !state.timer0.countingDown;
+                    } else {
+                        output = true;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void applyBottom(const uint8_t com, bool& output) {
+            if (2 == com) {
+                output = true;
+            } else if (3 == com) {
+                output = false;
+            }
+        }
+
+        void notifyPins() {
+            const uint8_t levels = pinLevels();
+            if (levels != state.lastPinLevels) {
+                // pin change flag is raised for watched pins whatever drives them
+                if ((levels ^ state.lastPinLevels) & reg(PCMSK)) {
+                    reg(GIFR) |= _BV(PCIF);
+                }
+                state.lastPinLevels = levels;
+                if (state.pinsListener) {
+                    state.pinsListener(state.now, levels);
+                }
+            }
+        }
+
+        void raiseTimerFlag(const uint8_t flag, const bool drivesOutput) {
+            state.timer0.flags |= _BV(flag);
+            // TIMSK0 enable bits sit at the positions of TIFR0 flags
+            if (drivesOutput || isBitSet(TIMSK0, flag)) {
+                state.timer0.eventCycle = state.now;
+            }
+        }
+
+        void timerTick() {
+            Timer0State& t = state.timer0;
+            const uint8_t mode = timerMode();
+            const uint8_t top = timerTop(mode);
+            const bool isFastPWM = mode == TimerFastPWM || mode == TimerFastPWMTopA;
+            const bool isPhaseCorrect = mode == TimerPhaseCorrect || mode == TimerPhaseCorrectTopA;
+
+            if (isPhaseCorrect) {
+                if (!t.countingDown && t.counter >= top) {
+                    t.countingDown = true;
+                    t.compareA = reg(OCR0A);
+                    t.compareB = reg(OCR0B);
+                }
+                if (t.countingDown) {
+                    t.counter--;
+                    if (0 == t.counter) {
+                        t.countingDown = false;
+                        raiseTimerFlag(TOV0, false);
+                    }
+                } else {
+                    t.counter++;
+                }
+            } else if (t.counter == top) {
+                if (0xFFu == t.counter || mode == TimerFastPWMTopA) {
+                    raiseTimerFlag(TOV0, isFastPWM && isOutputConnected(compareOutputModeA(), true));
+                }
+                t.counter = 0;
+                if (isFastPWM) {
+                    t.compareA = reg(OCR0A);
+                    t.compareB = reg(OCR0B);
+                    applyBottom(compareOutputModeA(), t.outputA);
+                    applyBottom(compareOutputModeB(), t.outputB);
+                }
+            } else {
+                t.counter++;
+            }
+
+            if (t.counter == t.compareA) {
+                raiseTimerFlag(OCF0A, isOutputConnected(compareOutputModeA(), true));
+                // compare value equal to TOP in fast pwm keeps output steady
+                if (!(isFastPWM && t.compareA == top && compareOutputModeA() != 1)) {
+                    applyCompareMatch(compareOutputModeA(), t.outputA);
+                }
+            }
+            if (t.counter == t.compareB) {
+                raiseTimerFlag(OCF0B, isOutputConnected(compareOutputModeB(), false));
+                if (!(isFastPWM && t.compareB == top)) {
+                    applyCompareMatch(compareOutputModeB(), t.outputB);
+                }
+            }
+
+            notifyPins();
+        }
+
+        uint32_t ticksUntilValue(const uint8_t value, const uint8_t top) {
+            const uint8_t counter = state.timer0.counter;
+            if (value > top) {
+                return UINT32_MAX;
+            }
+            if (value > counter) {
+                return value - counter;
+            }
+            return top - counter + 1u + value;
+        }
+
+        // timer ticks ahead that do nothing but increment the counter,
+        // lets the simulation skip them at once instead of ticking one by one
+        uint32_t quietTicksAhead() {
+            const uint8_t mode = timerMode();
+            const uint8_t top = timerTop(mode);
+            const uint8_t counter = state.timer0.counter;
+            if (mode == TimerPhaseCorrect || mode == TimerPhaseCorrectTopA || counter > top) {
+                return 0;
+            }
+            uint32_t ticks = top - counter + 1u;
+            const uint32_t ticksA = ticksUntilValue(state.timer0.compareA, top);
+            const uint32_t ticksB = ticksUntilValue(state.timer0.compareB, top);
+            ticks = ticksA < ticks ? ticksA : ticks;
+            ticks = ticksB < ticks ? ticksB : ticks;
+            return ticks - 1u;
+        }
+
+        bool isWatchdogRunning() {
+            return 0 != (reg(WDTCR) & (_BV(WDTIE) | _BV(WDE)));
+        }
+
+        // watchdog runs from its own 128 kHz oscillator, timeout is 2K << WDP of its cycles
+        uint64_t watchdogPeriod() {
+            const uint8_t wdtcr = reg(WDTCR);
+            const uint8_t prescale = static_cast<uint8_t>((wdtcr & (_BV(WDP2) | _BV(WDP1) | _BV(WDP0)))
+                    | ((wdtcr & _BV(WDP3)) ? 0b1000u : 0u));
+            const uint64_t oscillatorCycles = 2048ull << (prescale > 9u ? 9u : prescale);
+            return oscillatorCycles * CPU_FREQUENCY / WATCHDOG_OSCILLATOR_FREQUENCY;
+        }
+
+        void watchdogTimeout() {
+            state.watchdogStart = state.now;
+            if (isBitSet(WDTCR, WDTIE)) {
+                reg(WDTCR) |= _BV(WDTIF);
+            } else {
+                fprintf(stderr, "hostsim: watchdog reset is not simulated\n");
+            }
+        }
+
+        uint8_t pendingVector() {
+            if (isBitSet(GIFR, PCIF) && isBitSet(GIMSK, PCIE)) {
+                return PCINT0_vect_num;
+            }
+            const uint8_t timerPending = state.timer0.flags & reg(TIMSK0);
+            if (timerPending & _BV(TOV0)) {
+                return TIM0_OVF_vect_num;
+            }
+            if (timerPending & _BV(OCF0A)) {
+                return TIM0_COMPA_vect_num;
+            }
+            if (timerPending & _BV(OCF0B)) {
+                return TIM0_COMPB_vect_num;
+            }
+            if (isBitSet(WDTCR, WDTIF) && isBitSet(WDTCR, WDTIE)) {
+                return WDT_vect_num;
+            }
+            return 0;
+        }
+
+        void acknowledgeVector(const uint8_t vectorNumber) {
+            switch (vectorNumber) {
+                case PCINT0_vect_num:
+                    reg(GIFR) &= ~_BV(PCIF);
+                    break;
+                case TIM0_OVF_vect_num:
+                    state.timer0.flags &= ~_BV(TOV0);
+                    break;
+                case TIM0_COMPA_vect_num:
+                    state.timer0.flags &= ~_BV(OCF0A);
+                    break;
+                case TIM0_COMPB_vect_num:
+                    state.timer0.flags &= ~_BV(OCF0B);
+                    break;
+                case WDT_vect_num:
+                    reg(WDTCR) &= ~_BV(WDTIF);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void dispatchInterrupts() {
+            while (!state.isExternalCpu && isBitSet(SREG, SREG_I)) {
+                const uint8_t vectorNumber = pendingVector();
+                if (0 == vectorNumber) {
+                    break;
+                }
+                acknowledgeVector(vectorNumber);
+                const VectorHandler handler = vectors()[vectorNumber];
+                if (nullptr == handler) {
+                    fprintf(stderr, "hostsim: interrupt %u has no handler\n", vectorNumber);
+                    continue;
+                }
+                reg(SREG) &= ~_BV(SREG_I);
+                handler();
+                reg(SREG) |= _BV(SREG_I);
+                state.interruptsServed++;
+            }
+        }
+
+        void applyDueInputs() {
+            bool changed = false;
+            while (state.nextInput < state.inputs.size() && state.inputs[state.nextInput].cycle <= state.now) {
+                state.groundedPins = state.inputs[state.nextInput].groundedPins;
+                state.nextInput++;
+                changed = true;
+            }
+            if (changed) {
+                notifyPins();
+            }
+        }
+    }
+
+    void registerVector(const uint8_t vectorNumber, const VectorHandler handler) {
+        vectors()[vectorNumber] = handler;
+    }
+
+    void globalInterruptsEnable() {
+        reg(SREG) |= _BV(SREG_I);
+    }
+
+    void globalInterruptsDisable() {
+        reg(SREG) &= ~_BV(SREG_I);
+    }
+
+    uint8_t registerRead(const uint8_t address) {
+        switch (address) {
+            case PINB:
+                return pinLevels();
+            case TCNT0:
+                return state.timer0.counter;
+            case TIFR0:
+                return state.timer0.flags;
+            default:
+                return reg(address);
+        }
+    }
+
+    void registerWrite(const uint8_t address, const uint8_t value) {
+        switch (address) {
+            case PINB:
+                // writing ones to PINx toggles PORTx
+                reg(PORTB) ^= value & PORTB_PINS_MASK;
+                break;
+            case TCNT0:
+                state.timer0.counter = value;
+                break;
+            case TIFR0:
+                state.timer0.flags &= ~value;
+                break;
+            case GIFR:
+                // flags are cleared by writing one
+                reg(GIFR) &= ~value;
+                break;
+            case OCR0A:
+                reg(address) = value;
+                if (!isPWMMode(timerMode())) {
+                    state.timer0.compareA = value;
+                }
+                break;
+            case OCR0B:
+                reg(address) = value;
+                if (!isPWMMode(timerMode())) {
+                    state.timer0.compareB = value;
+                }
+                break;
+            case EECR: {
+                // erase and write in one go (EEPM = 0) is the only mode firmware uses
+                const bool isWrite = (value & _BV(EEPE)) && isBitSet(EECR, EEMPE);
+                if (isWrite) {
+                    state.eeprom[reg(EEARL) % EEPROM_SIZE] = reg(EEDR);
+                }
+                if (value & _BV(EERE)) {
+                    reg(EEDR) = state.eeprom[reg(EEARL) % EEPROM_SIZE];
+                }
+                reg(address) = value & ~(_BV(EEPE) | _BV(EERE) | (isWrite ? _BV(EEMPE) : 0));
+                break;
+            }
+            case WDTCR: {
+                const bool wasRunning = isWatchdogRunning();
+                // WDTIF is cleared by writing one
+                const uint8_t flag = (reg(WDTCR) & ~value) & _BV(WDTIF);
+                reg(WDTCR) = (value & ~_BV(WDTIF)) | flag;
+                if (!wasRunning) {
+                    state.watchdogStart = state.now;
+                }
+                break;
+            }
+            case TCCR0B:
+                if (!isPWMMode(timerMode())) {
+                    if (value & _BV(FOC0A)) {
+                        applyCompareMatch(compareOutputModeA(), state.timer0.outputA);
+                    }
+                    if (value & _BV(FOC0B)) {
+                        applyCompareMatch(compareOutputModeB(), state.timer0.outputB);
+                    }
+                }
+                reg(address) = value & ~(_BV(FOC0A) | _BV(FOC0B));
+                break;
+            default:
+                reg(address) = value;
+                break;
+        }
+        notifyPins();
+    }
+
+    void reset() {
+        state = SimState();
+        for (uint8_t& byte : state.eeprom) {
+            byte = 0xFFu;
+        }
+    }
+
+    void setExternalCpu(const bool isExternal) {
+        state.isExternalCpu = isExternal;
+    }
+
+    uint8_t takeInterrupt() {
+        const uint8_t vectorNumber = pendingVector();
+        if (0 != vectorNumber) {
+            acknowledgeVector(vectorNumber);
+            state.interruptsServed++;
+        }
+        return vectorNumber;
+    }
+
+    uint8_t eepromByte(const uint16_t address) {
+        return state.eeprom[address % EEPROM_SIZE];
+    }
+
+    uint64_t now() {
+        return state.now;
+    }
+
+    void watchdogReset() {
+        state.watchdogStart = state.now;
+    }
+
+    uint64_t timer0EventCycle() {
+        return state.timer0.eventCycle;
+    }
+
+    uint64_t interruptsServed() {
+        return state.interruptsServed;
+    }
+
+    uint64_t poweredDownCycles() {
+        return state.poweredDownCycles;
+    }
+
+    void stopAt(const uint64_t cycle) {
+        state.stopCycle = cycle;
+    }
+
+    void scheduleInputs(const std::vector<InputEvent>& events) {
+        state.inputs = events;
+        state.nextInput = 0;
+        applyDueInputs();
+    }
+
+    void setPinsListener(const PinsListener& listener) {
+        state.pinsListener = listener;
+        state.lastPinLevels = pinLevels();
+        if (state.pinsListener) {
+            state.pinsListener(state.now, state.lastPinLevels);
+        }
+    }
+
+    uint8_t pinLevels() {
+        const uint8_t ddr = reg(DDRB);
+        uint8_t outputs = reg(PORTB);
+        if (isOutputConnected(compareOutputModeA(), true)) {
+            outputs = state.timer0.outputA ? (outputs | _BV(PB0)) : (outputs & ~_BV(PB0));
+        }
+        if (isOutputConnected(compareOutputModeB(), false)) {
+            outputs = state.timer0.outputB ? (outputs | _BV(PB1)) : (outputs & ~_BV(PB1));
+        }
+        // undriven inputs idle high, through the pull-up or the LED of ComboPin circuit
+        const uint8_t levels = (ddr & outputs) | ~ddr;
+        return levels & ~state.groundedPins & PORTB_PINS_MASK;
+    }
+
+    // with untilInterrupt, returns as soon as an interrupt has been served
+    static void advance(uint64_t cycles, const bool untilInterrupt) {
+        const uint64_t servedBefore = state.interruptsServed;
+        dispatchInterrupts();
+        while (!untilInterrupt || (state.isExternalCpu ? 0 == pendingVector() : state.interruptsServed == servedBefore)) {
+            if (state.now >= state.stopCycle) {
+                throw SimulationStop();
+            }
+            if (0 == cycles) {
+                break;
+            }
+            applyDueInputs();
+
+            uint64_t step = cycles;
+            if (state.nextInput < state.inputs.size()) {
+                const uint64_t untilInput = state.inputs[state.nextInput].cycle - state.now;
+                step = step < untilInput ? step : untilInput;
+            }
+            const uint64_t untilStop = state.stopCycle - state.now;
+            step = step < untilStop ? step : untilStop;
+            if (isWatchdogRunning()) {
+                const uint64_t watchdogEnd = state.watchdogStart + watchdogPeriod();
+                const uint64_t untilWatchdog = watchdogEnd > state.now ? watchdogEnd - state.now : 0;
+                if (0 == untilWatchdog) {
+                    watchdogTimeout();
+                    dispatchInterrupts();
+                    continue;
+                }
+                step = step < untilWatchdog ? step : untilWatchdog;
+            }
+
+            const uint32_t prescaler = timerPrescaler();
+            if (0 != prescaler) {
+                const uint64_t untilTick = prescaler - state.now % prescaler;
+                const uint32_t quietTicks = quietTicksAhead();
+                if (0 != quietTicks && step >= untilTick) {
+                    uint64_t ticks = 1u + (step - untilTick) / prescaler;
+                    ticks = ticks < quietTicks ? ticks : quietTicks;
+                    const uint64_t skip = untilTick + (ticks - 1u) * prescaler;
+                    state.now += skip;
+                    cycles -= skip;
+                    state.timer0.counter += static_cast<uint8_t>(ticks);
+                    continue;
+                }
+                step = step < untilTick ? step : untilTick;
+            }
+
+            state.now += step;
+            cycles -= step;
+
+            if (0 != prescaler && 0 == state.now % prescaler) {
+                timerTick();
+            }
+            dispatchInterrupts();
+        }
+    }
+
+    void advanceCycles(const uint32_t cycles) {
+        advance(cycles, false);
+    }
+
+    void sleepUntilInterrupt(const bool isPowerDown) {
+        const uint64_t start = state.now;
+        state.isPoweredDown = isPowerDown;
+        try {
+            advance(UINT64_MAX, true);
+        } catch (const SimulationStop&) {
+            state.isPoweredDown = false;
+            state.poweredDownCycles += isPowerDown ? state.now - start : 0;
+            throw;
+        }
+        state.isPoweredDown = false;
+        state.poweredDownCycles += isPowerDown ? state.now - start : 0;
+    }
+}
+
+// -------- FIRMWARE RUNTIME --------
+
+// host versions of m-toolbox pieces that only make sense on the chip
+
+void fixedDelayLong() {
+    hostsim::advanceCycles(hostsim::FIXED_DELAY_LONG_CYCLES);
+}
+
+unsigned char __builtin_avr_swap(const unsigned char value) {
+    return static_cast<unsigned char>((value << 4u) | (value >> 4u));
+}
+
+void __builtin_avr_delay_cycles(const unsigned long count) {
+    hostsim::advanceCycles(static_cast<uint32_t>(count));
+}
+
+void __builtin_avr_nops(const unsigned long count) {
+    hostsim::advanceCycles(static_cast<uint32_t>(count));
+}
+
+void __builtin_avr_no_operation() {
+    hostsim::advanceCycles(1);
+}
+
+void __builtin_avr_sleep() {
+    // sleep instruction does nothing until sleep is enabled
+    if (0 == (hostsim::registerRead(MCUCR) & _BV(SE))) {
+        hostsim::advanceCycles(1);
+        return;
+    }
+    if (0 == (hostsim::registerRead(SREG) & _BV(SREG_I))) {
+        fprintf(stderr, "hostsim: sleep with interrupts disabled never wakes\n");
+    }
+    // wake on the first interrupt served, modes other than power-down run as idle
+    const uint8_t mode = hostsim::registerRead(MCUCR) & (_BV(SM1) | _BV(SM0));
+    hostsim::sleepUntilInterrupt(_BV(SM1) == mode);
+}
@@ -0,0 +1,87 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+// simulated attiny13a peripherals for running firmware sources on the host
+// - Timer0 (normal, ctc, fast pwm, phase correct; prescalers; compare outputs)
+// - watchdog timeout interrupt
+// - PORTB pins with buttons shorting inputs to ground, pin change interrupt
+// - idle and power-down sleep
+// - eeprom reads and writes, writes complete at once
+// - interrupt dispatch in vector priority order
+// time only moves forward when firmware delays (fixedDelayLong, _delay_*) or sleeps, everything
+// the firmware does in between is considered to take zero cycles
+// with an external cpu (instruction-level emulator) the cpu advances time per instruction
+// and takes interrupts itself, through takeInterrupt()
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+namespace hostsim {
+    const uint32_t CPU_FREQUENCY = F_CPU;
+
+    const uint32_t WATCHDOG_OSCILLATOR_FREQUENCY = 128000;
+
+    const uint16_t EEPROM_SIZE = 64;
+
+    // avr-gcc -Os turns Utils.cpp loop into 255 x (nop, subi, brne), plus rcall/ret
+    const uint32_t FIXED_DELAY_LONG_CYCLES = 255u * 4u + 7u;
+
+    // thrown from inside firmware delays once the simulation reaches its stop time
+    struct SimulationStop {
+    };
+
+    struct InputEvent {
+        uint64_t cycle;
+
+        // bit per PORTB pin, set bit means the pin is shorted to ground
+        uint8_t groundedPins;
+    };
+
+    typedef std::function<void(uint64_t cycle, uint8_t pinLevels)> PinsListener;
+
+    void reset();
+
+    // interrupts stop being dispatched to registered handlers, sleeping ends once one is pending
+    void setExternalCpu(bool isExternal);
+
+    // highest priority pending interrupt, acknowledged, 0 when none is pending
+    uint8_t takeInterrupt();
+
+    uint8_t eepromByte(uint16_t address);
+
+    uint64_t now();
+
+    // cycle of the latest Timer0 overflow or compare match, pin edges are timed against it
+    uint64_t timer0EventCycle();
+
+    uint64_t interruptsServed();
+
+    uint64_t poweredDownCycles();
+
+    void watchdogReset();
+
+    void stopAt(uint64_t cycle);
+
+    void advanceCycles(uint32_t cycles);
+
+    // runs until an interrupt has been served (external cpu: is pending), power-down halts Timer0 meanwhile
+    void sleepUntilInterrupt(bool isPowerDown);
+
+    void scheduleInputs(const std::vector<InputEvent>& events);
+
+    void setPinsListener(const PinsListener& listener);
+
+    uint8_t pinLevels();
+
+    inline uint64_t secondsToCycles(const double seconds) {
+        return static_cast<uint64_t>(seconds * CPU_FREQUENCY);
+    }
+
+    inline double cyclesToSeconds(const uint64_t cycles) {
+        return static_cast<double>(cycles) / CPU_FREQUENCY;
+    }
+}
+
+#endif // HOST_SIM_H
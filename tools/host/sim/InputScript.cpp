@@ -0,0 +1,66 @@
+#include "InputScript.h"
+
+#include <avr/io.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+namespace hostsim {
+    namespace {
+        bool buttonPin(const std::string& name, uint8_t& pin) {
+            // see UIDriver pins in main.cpp
+            static const std::map<std::string, uint8_t> PINS = {
+                { "mode",  PB4 },
+                { "minus", PB3 },
+                { "click", PB2 },
+                { "plus",  PB1 },
+            };
+            const auto it = PINS.find(name);
+            if (it == PINS.end()) {
+                return false;
+            }
+            pin = it->second;
+            return true;
+        }
+    }
+
+    bool InputScript::addPress(const char* spec) {
+        const char* at = strchr(spec, '@');
+        if (nullptr == at) {
+            return false;
+        }
+        uint8_t pin = 0;
+        if (!buttonPin(std::string(spec, at), pin)) {
+            return false;
+        }
+        char* end = nullptr;
+        const double start = strtod(at + 1, &end);
+        double length = 0.1;
+        if (':' == *end) {
+            length = strtod(end + 1, &end);
+        }
+        if ('\0' != *end || start < 0 || length <= 0) {
+            return false;
+        }
+        pressEdges.emplace(secondsToCycles(start), std::make_pair(pin, true));
+        pressEdges.emplace(secondsToCycles(start + length), std::make_pair(pin, false));
+        return true;
+    }
+
+    std::vector<InputEvent> InputScript::events() const {
+        std::vector<InputEvent> events;
+        uint8_t grounded = 0;
+        for (const auto& edge : pressEdges) {
+            const uint8_t mask = static_cast<uint8_t>(1u << edge.second.first);
+            grounded = edge.second.second ? (grounded | mask) : (grounded & ~mask);
+            if (!events.empty() && events.back().cycle == edge.first) {
+                events.back().groundedPins = grounded;
+            } else {
+                events.push_back(InputEvent { edge.first, grounded });
+            }
+        }
+        return events;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef HOST_INPUT_SCRIPT_H
+#define HOST_INPUT_SCRIPT_H
+
+// button presses given on host tools command lines, as simulator input events
+// press spec is BUTTON@START[:LENGTH], BUTTON is one of mode, minus, click, plus,
+// START and LENGTH are seconds (LENGTH defaults to 0.1)
+
+#include "HostSim.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace hostsim {
+    class InputScript {
+    public:
+        // false when the spec is malformed
+        bool addPress(const char* spec);
+
+        std::vector<InputEvent> events() const;
+
+    private:
+        // press start/end cycle -> PORTB pin, is pressed
+        std::multimap<uint64_t, std::pair<uint8_t, bool>> pressEdges;
+    };
+}
+
+#endif // HOST_INPUT_SCRIPT_H
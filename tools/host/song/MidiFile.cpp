@@ -0,0 +1,196 @@
+#include "MidiFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // 120 bpm until the first tempo event
+    const uint32_t DEFAULT_QUARTER_MICROS = 500000u;
+
+    const uint8_t META_TEMPO = 0x51u;
+
+    const uint8_t META_END_OF_TRACK = 0x2Fu;
+
+    uint32_t bigEndian(const std::vector<uint8_t>& data, const size_t offset, const uint8_t bytes) {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < bytes; i++) {
+            value = (value << 8u) | data[offset + i];
+        }
+        return value;
+    }
+
+    bool variableLength(const std::vector<uint8_t>& data, size_t& offset, const size_t end, uint32_t& value) {
+        value = 0;
+        for (uint8_t i = 0; i < 4u; i++) {
+            if (offset >= end) {
+                return false;
+            }
+            const uint8_t byte = data[offset++];
+            value = (value << 7u) | (byte & 0x7Fu);
+            if (0 == (byte & 0x80u)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool MidiFile::load(const char* path, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "can not read '" + std::string(path) + "'";
+        return false;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 14u || 0 != std::string(data.begin(), data.begin() + 4).compare("MThd")) {
+        error = "not a midi file";
+        return false;
+    }
+    const uint32_t headerLength = bigEndian(data, 4, 4);
+    const uint16_t format = static_cast<uint16_t>(bigEndian(data, 8, 2));
+    const uint16_t tracks = static_cast<uint16_t>(bigEndian(data, 10, 2));
+    const uint16_t division = static_cast<uint16_t>(bigEndian(data, 12, 2));
+    if (format > 1u) {
+        error = "only midi formats 0 and 1 are supported";
+        return false;
+    }
+    if (0 != (division & 0x8000u) || 0 == division) {
+        error = "smpte time division is not supported";
+        return false;
+    }
+    ticksPerQuarter = division;
+    tempos.clear();
+    tempos.push_back(Tempo { 0, DEFAULT_QUARTER_MICROS });
+    tickNotes.clear();
+    allNotes.clear();
+
+    size_t offset = 8u + headerLength;
+    for (uint16_t track = 0; track < tracks; track++) {
+        if (!readTrack(data, offset, error)) {
+            return false;
+        }
+    }
+
+    std::stable_sort(tempos.begin(), tempos.end(), [](const Tempo& a, const Tempo& b) {
+        return a.tick < b.tick;
+    });
+    for (const TickNote& note : tickNotes) {
+        allNotes.push_back(MidiNote {
+                seconds(note.start), seconds(note.end),
+                static_cast<double>(note.start) / ticksPerQuarter, static_cast<double>(note.end) / ticksPerQuarter,
+                note.pitch, note.channel });
+    }
+    std::stable_sort(allNotes.begin(), allNotes.end(), [](const MidiNote& a, const MidiNote& b) {
+        return a.start < b.start;
+    });
+    return true;
+}
+
+bool MidiFile::readTrack(const std::vector<uint8_t>& data, size_t& offset, std::string& error) {
+    if (offset + 8u > data.size() || 0 != std::string(data.begin() + offset, data.begin() + offset + 4).compare("MTrk")) {
+        error = "missing track chunk";
+        return false;
+    }
+    const size_t end = offset + 8u + bigEndian(data, offset + 4u, 4);
+    if (end > data.size()) {
+        error = "track runs past the end of the file";
+        return false;
+    }
+    offset += 8u;
+
+    // start tick of every sounding note, by channel and pitch, repeated note ons stack
+    std::vector<uint32_t> sounding[16][128];
+    uint32_t tick = 0;
+    uint8_t status = 0;
+    while (offset < end) {
+        uint32_t delta = 0;
+        if (!variableLength(data, offset, end, delta) || offset >= end) {
+            error = "truncated track";
+            return false;
+        }
+        tick += delta;
+        if (0 != (data[offset] & 0x80u)) {
+            status = data[offset++];
+        } else if (0 == status) {
+            error = "running status without a status";
+            return false;
+        }
+
+        if (0xFFu == status) {
+            if (offset >= end) {
+                error = "truncated meta event";
+                return false;
+            }
+            const uint8_t type = data[offset++];
+            uint32_t length = 0;
+            if (!variableLength(data, offset, end, length) || offset + length > end) {
+                error = "truncated meta event";
+                return false;
+            }
+            if (META_TEMPO == type && 3u == length) {
+                tempos.push_back(Tempo { tick, bigEndian(data, offset, 3) });
+            }
+            offset += length;
+            // meta and sysex events cancel running status
+            status = 0;
+            if (META_END_OF_TRACK == type) {
+                break;
+            }
+            continue;
+        }
+        if (0xF0u == status || 0xF7u == status) {
+            uint32_t length = 0;
+            if (!variableLength(data, offset, end, length) || offset + length > end) {
+                error = "truncated sysex event";
+                return false;
+            }
+            offset += length;
+            status = 0;
+            continue;
+        }
+
+        const uint8_t type = status & 0xF0u;
+        const uint8_t channel = status & 0x0Fu;
+        const uint8_t dataBytes = 0xC0u == type || 0xD0u == type ? 1u : 2u;
+        if (offset + dataBytes > end) {
+            error = "truncated channel event";
+            return false;
+        }
+        const uint8_t pitch = data[offset] & 0x7Fu;
+        const uint8_t velocity = 2u == dataBytes ? data[offset + 1u] & 0x7Fu : 0;
+        offset += dataBytes;
+        if (0x90u == type && 0 != velocity) {
+            sounding[channel][pitch].push_back(tick);
+        } else if ((0x80u == type || 0x90u == type) && !sounding[channel][pitch].empty()) {
+            tickNotes.push_back(TickNote { sounding[channel][pitch].front(), tick, pitch, static_cast<uint8_t>(channel + 1u) });
+            sounding[channel][pitch].erase(sounding[channel][pitch].begin());
+        }
+    }
+    offset = end;
+
+    // notes never released end with the track
+    for (uint8_t channel = 0; channel < 16u; channel++) {
+        for (uint8_t pitch = 0; pitch < 128u; pitch++) {
+            for (const uint32_t start : sounding[channel][pitch]) {
+                tickNotes.push_back(TickNote { start, tick, pitch, static_cast<uint8_t>(channel + 1u) });
+            }
+        }
+    }
+    return true;
+}
+
+double MidiFile::seconds(const uint32_t tick) const {
+    double result = 0;
+    uint32_t fromTick = 0;
+    uint32_t quarterMicros = DEFAULT_QUARTER_MICROS;
+    for (const Tempo& tempo : tempos) {
+        if (tempo.tick >= tick) {
+            break;
+        }
+        result += static_cast<double>(tempo.tick - fromTick) * quarterMicros / ticksPerQuarter / 1e6;
+        fromTick = tempo.tick;
+        quarterMicros = tempo.quarterMicros;
+    }
+    return result + static_cast<double>(tick - fromTick) * quarterMicros / ticksPerQuarter / 1e6;
+}
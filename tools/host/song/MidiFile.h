@@ -0,0 +1,69 @@
+#ifndef HOST_MIDI_FILE_H
+#define HOST_MIDI_FILE_H
+
+// notes of a standard midi file (format 0 or 1, ticks per quarter note division),
+// timed through its tempo map; running status, sysex and meta events other than tempo are skipped
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct MidiNote {
+    double start;
+
+    double end;
+
+    // quarter notes from the start of the file
+    double startQuarters;
+
+    double endQuarters;
+
+    uint8_t pitch;
+
+    // 1..16
+    uint8_t channel;
+};
+
+class MidiFile {
+public:
+    bool load(const char* path, std::string& error);
+
+    // by start time
+    const std::vector<MidiNote>& notes() const {
+        return allNotes;
+    }
+
+private:
+    struct Tempo {
+        uint32_t tick;
+
+        // microseconds per quarter note
+        uint32_t quarterMicros;
+    };
+
+    struct TickNote {
+        uint32_t start;
+
+        uint32_t end;
+
+        uint8_t pitch;
+
+        uint8_t channel;
+    };
+
+    uint16_t ticksPerQuarter = 0;
+
+    std::vector<Tempo> tempos;
+
+    // tempo changes may come in a later track, notes get their times once all tracks are read
+    std::vector<TickNote> tickNotes;
+
+    std::vector<MidiNote> allNotes;
+
+    bool readTrack(const std::vector<uint8_t>& data, size_t& offset, std::string& error);
+
+    double seconds(uint32_t tick) const;
+};
+
+#endif // HOST_MIDI_FILE_H
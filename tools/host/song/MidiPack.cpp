@@ -0,0 +1,323 @@
+// packs the melody of a standard midi file into a header for SongStream, with the smallest notes table
+// it needs, and prints the flash it takes and the pitch error it comes with
+//
+// usage: ATTiny13MidiPack <song.mid> <header> [--name NAME] [--channel N]... [--beat S | --per-quarter N]
+//                         [--lowest NOTE] [--highest NOTE] [--tail N]
+//   NAME is the namespace the header puts the song in (default SampleSong)
+//   N channels (1..16) to take notes from, all but the drums channel 10 by default
+//   beats last S seconds of the file (default 0.125, the firmware beat), or a quarter note is N beats
+//   notes are moved by octaves into NOTE..NOTE (default C6..B7, the range the engines are checked for)
+//   N rest beats are added before the song starts over (default 8)
+//
+// beats take the highest note sounding at them, a note lasts at least a beat;
+// when the song plays more than 14 different notes the least played ones go to their nearest neighbour
+// the beats are cut into patterns of 4, 8, 16, 32 and 64 beats, and into a single one,
+// the arrangement taking the least flash is written
+// exits with 1 when the song can not be packed
+
+#include "MidiFile.h"
+#include "SongPacker.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+    const double DEFAULT_BEAT_SECONDS = 0.125;
+
+    const uint8_t DRUMS_CHANNEL = 10u;
+
+    const char* const DEFAULT_LOWEST = "C6";
+
+    const char* const DEFAULT_HIGHEST = "B7";
+
+    const uint32_t DEFAULT_TAIL_BEATS = 8u;
+
+    const uint32_t PATTERN_BEATS[] = { 4u, 8u, 16u, 32u, 64u };
+
+    const uint32_t CENTS_PER_SEMITONE = 100u;
+
+    const char* const DEFAULT_NAME = "SampleSong";
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13MidiPack <song.mid> <header> [--name NAME] [--channel N]...\n"
+                        "                        [--beat S | --per-quarter N] [--lowest NOTE] [--highest NOTE] [--tail N]\n");
+    }
+
+    struct Options {
+        const char* name = DEFAULT_NAME;
+
+        std::vector<uint8_t> channels;
+
+        double beatSeconds = DEFAULT_BEAT_SECONDS;
+
+        uint32_t beatsPerQuarter = 0;
+
+        uint8_t lowest = 0;
+
+        uint8_t highest = 0;
+
+        uint32_t tailBeats = DEFAULT_TAIL_BEATS;
+    };
+
+    bool isTaken(const Options& options, const uint8_t channel) {
+        if (options.channels.empty()) {
+            return DRUMS_CHANNEL != channel;
+        }
+        for (const uint8_t taken : options.channels) {
+            if (taken == channel) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // midi note of every beat, 0 for none
+    std::vector<uint8_t> quantize(const std::vector<MidiNote>& notes, const Options& options, uint32_t& dropped) {
+        std::vector<uint8_t> beats;
+        // the note heard in the beat starts in it
+        std::vector<bool> isStart;
+        for (const MidiNote& note : notes) {
+            if (!isTaken(options, note.channel)) {
+                continue;
+            }
+            const double start = 0 != options.beatsPerQuarter
+                    ? note.startQuarters * options.beatsPerQuarter : note.start / options.beatSeconds;
+            const double end = 0 != options.beatsPerQuarter
+                    ? note.endQuarters * options.beatsPerQuarter : note.end / options.beatSeconds;
+            const size_t first = static_cast<size_t>(lround(start));
+            const size_t last = std::max(first + 1u, static_cast<size_t>(lround(end)));
+            if (beats.size() < last) {
+                beats.resize(last, 0);
+                isStart.resize(last, false);
+            }
+            for (size_t beat = first; beat < last; beat++) {
+                if (note.pitch > beats[beat] || (note.pitch == beats[beat] && beat == first)) {
+                    beats[beat] = note.pitch;
+                    isStart[beat] = beat == first;
+                }
+            }
+        }
+        // the firmware holds a note through beats of the same note, a note struck again
+        // takes the last beat off the one before, when that one is longer than a beat
+        for (size_t beat = 2; beat < beats.size(); beat++) {
+            if (isStart[beat] && beats[beat - 1u] == beats[beat] && !isStart[beat - 1u]) {
+                beats[beat - 1u] = 0;
+            }
+        }
+        // notes not heard in any beat, under higher ones
+        dropped = 0;
+        for (const MidiNote& note : notes) {
+            if (!isTaken(options, note.channel)) {
+                continue;
+            }
+            const double start = 0 != options.beatsPerQuarter
+                    ? note.startQuarters * options.beatsPerQuarter : note.start / options.beatSeconds;
+            const size_t first = static_cast<size_t>(lround(start));
+            dropped += beats[first] != note.pitch ? 1u : 0u;
+        }
+        return beats;
+    }
+
+    // moves notes by octaves into lowest..highest, returns the beats moved
+    uint32_t fold(std::vector<uint8_t>& beats, const uint8_t lowest, const uint8_t highest) {
+        uint32_t moved = 0;
+        for (uint8_t& beat : beats) {
+            if (0 == beat) {
+                continue;
+            }
+            const uint8_t original = beat;
+            while (beat < lowest) {
+                beat = static_cast<uint8_t>(beat + 12u);
+            }
+            while (beat > highest) {
+                beat = static_cast<uint8_t>(beat - 12u);
+            }
+            moved += original != beat ? 1u : 0u;
+        }
+        return moved;
+    }
+
+    // notes table by rising pitch, at most SONG_MAX_NOTE notes, beats get note indices into it;
+    // errors are the cents every beat is off the note it should play
+    std::vector<uint8_t> pickNotes(std::vector<uint8_t>& beats, uint32_t& maxCents, double& meanCents) {
+        std::map<uint8_t, uint32_t> plays;
+        for (const uint8_t beat : beats) {
+            if (0 != beat) {
+                plays[beat]++;
+            }
+        }
+        // played note -> note it is played as
+        std::map<uint8_t, uint8_t> playedAs;
+        for (const auto& note : plays) {
+            playedAs[note.first] = note.first;
+        }
+        while (plays.size() > SONG_MAX_NOTE) {
+            auto rarest = plays.begin();
+            for (auto note = plays.begin(); note != plays.end(); ++note) {
+                rarest = note->second < rarest->second ? note : rarest;
+            }
+            auto below = rarest;
+            auto above = std::next(rarest);
+            const bool hasBelow = plays.begin() != rarest;
+            if (hasBelow) {
+                --below;
+            }
+            const bool isBelow = hasBelow
+                    && (plays.end() == above || rarest->first - below->first <= above->first - rarest->first);
+            const auto target = isBelow ? below : above;
+            target->second += rarest->second;
+            for (auto& note : playedAs) {
+                note.second = note.second == rarest->first ? target->first : note.second;
+            }
+            plays.erase(rarest);
+        }
+
+        std::vector<uint8_t> notes;
+        std::map<uint8_t, uint8_t> indices;
+        for (const auto& note : plays) {
+            notes.push_back(note.first);
+            indices[note.first] = static_cast<uint8_t>(notes.size());
+        }
+        maxCents = 0;
+        uint64_t sumCents = 0;
+        uint32_t played = 0;
+        for (uint8_t& beat : beats) {
+            if (0 == beat) {
+                continue;
+            }
+            const uint8_t as = playedAs[beat];
+            const uint32_t cents = CENTS_PER_SEMITONE * static_cast<uint32_t>(abs(as - beat));
+            maxCents = std::max(maxCents, cents);
+            sumCents += cents;
+            played++;
+            beat = indices[as];
+        }
+        meanCents = 0 != played ? static_cast<double>(sumCents) / played : 0;
+        return notes;
+    }
+
+    SongSource arrange(const std::vector<uint8_t>& notes, const std::vector<uint8_t>& beats, const size_t patternBeats) {
+        SongSource source;
+        source.notes = notes;
+        for (size_t first = 0; first < beats.size(); first += patternBeats) {
+            const size_t last = std::min(beats.size(), first + patternBeats);
+            source.patterns.push_back(SongSource::Pattern {
+                    "beats " + std::to_string(first) + ".." + std::to_string(last - 1u),
+                    std::vector<uint8_t>(beats.begin() + first, beats.begin() + last) });
+            source.entries.push_back(SongSource::Entry { source.patterns.size() - 1u, 1u, 0 });
+        }
+        return source;
+    }
+
+    std::string baseName(const std::string& path) {
+        const size_t slash = path.find_last_of('/');
+        return std::string::npos == slash ? path : path.substr(slash + 1u);
+    }
+}
+
+int main(const int argc, char** argv) {
+    const char* songPath = nullptr;
+    const char* headerPath = nullptr;
+    Options options;
+    const char* lowest = DEFAULT_LOWEST;
+    const char* highest = DEFAULT_HIGHEST;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--name") && i + 1 < argc) {
+            options.name = argv[++i];
+        } else if (0 == strcmp(argv[i], "--channel") && i + 1 < argc) {
+            options.channels.push_back(static_cast<uint8_t>(atoi(argv[++i])));
+        } else if (0 == strcmp(argv[i], "--beat") && i + 1 < argc) {
+            options.beatSeconds = atof(argv[++i]);
+        } else if (0 == strcmp(argv[i], "--per-quarter") && i + 1 < argc) {
+            options.beatsPerQuarter = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (0 == strcmp(argv[i], "--lowest") && i + 1 < argc) {
+            lowest = argv[++i];
+        } else if (0 == strcmp(argv[i], "--highest") && i + 1 < argc) {
+            highest = argv[++i];
+        } else if (0 == strcmp(argv[i], "--tail") && i + 1 < argc) {
+            options.tailBeats = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if ('-' != argv[i][0] && nullptr == songPath) {
+            songPath = argv[i];
+        } else if ('-' != argv[i][0] && nullptr == headerPath) {
+            headerPath = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (nullptr == headerPath || options.beatSeconds <= 0
+        || !parseNoteName(lowest, options.lowest) || !parseNoteName(highest, options.highest)
+        || options.highest < options.lowest + 11u) {
+        usage();
+        return 2;
+    }
+
+    MidiFile midi;
+    std::string error;
+    if (!midi.load(songPath, error)) {
+        fprintf(stderr, "%s: %s\n", songPath, error.c_str());
+        return 1;
+    }
+    uint32_t dropped = 0;
+    std::vector<uint8_t> beats = quantize(midi.notes(), options, dropped);
+    if (beats.empty()) {
+        fprintf(stderr, "%s: no notes on the channels taken\n", songPath);
+        return 1;
+    }
+    beats.resize(beats.size() + options.tailBeats, 0);
+    const uint32_t folded = fold(beats, options.lowest, options.highest);
+    uint32_t maxCents = 0;
+    double meanCents = 0;
+    const std::vector<uint8_t> notes = pickNotes(beats, maxCents, meanCents);
+
+    printf("%s: %zu midi notes, %zu beats, %u notes hidden by higher ones, %u beats moved by octaves\n",
+           baseName(songPath).c_str(), midi.notes().size(), beats.size(), dropped, folded);
+    printf("notes table       %zu notes:", notes.size());
+    for (const uint8_t note : notes) {
+        printf(" %s", noteName(note).c_str());
+    }
+    printf("\npitch error       %u cents at most, %.1f on average\n", maxCents, meanCents);
+
+    PackedSong best;
+    std::string bestArrangement;
+    std::vector<size_t> arrangements(PATTERN_BEATS, PATTERN_BEATS + sizeof(PATTERN_BEATS) / sizeof(PATTERN_BEATS[0]));
+    arrangements.push_back(beats.size());
+    for (const size_t patternBeats : arrangements) {
+        PackedSong packed;
+        const std::string arrangement = beats.size() == patternBeats
+                ? "one pattern" : std::to_string(patternBeats) + " beat patterns";
+        if (!packSong(arrange(notes, beats, patternBeats), packed, error)) {
+            printf("%-17s %s\n", arrangement.c_str(), error.c_str());
+            continue;
+        }
+        if (unpackSong(packed) != packed.passBeats) {
+            fprintf(stderr, "%s: packed song does not play back\n", songPath);
+            return 1;
+        }
+        printf("%-17s %u bytes, %zu of %zu patterns kept, %zu entries\n", arrangement.c_str(), packed.flashBytes(),
+               packed.patternNames.size(), packed.playedPatterns, packed.entries.size());
+        if (bestArrangement.empty() || packed.flashBytes() < best.flashBytes()) {
+            best = packed;
+            bestArrangement = arrangement;
+        }
+    }
+    if (bestArrangement.empty()) {
+        fprintf(stderr, "%s: song does not fit any arrangement\n", songPath);
+        return 1;
+    }
+    if (!writeSongHeader(best, options.name, "ATTiny13MidiPack", baseName(songPath), headerPath)) {
+        fprintf(stderr, "can not write '%s'\n", headerPath);
+        return 2;
+    }
+    printf("flash             %u bytes with %s, %u written out as one melody\n",
+           best.flashBytes(), bestArrangement.c_str(), best.flatFlashBytes());
+    return 0;
+}
@@ -0,0 +1,247 @@
+// packs a song written as text into a header for SongStream, prints what the arrangement saves
+//
+// usage: ATTiny13SongPack <song> <header> [--name NAME]
+//   NAME is the namespace the header puts the song in (default SampleSong)
+//
+// song file, `#` starts a comment:
+//   noise D6                 optional, before any section: notes up to D6 are drums, FlashMemoryMelody
+//                            plays them as noise
+//   pattern intro            beats follow until the next section, one token a beat:
+//     E7 E7 - E7 - C7 E7 -     C6..B7 (note indices 1..14 of the notes table), `-` rest,
+//     G7 - - - G6 - - -        `.` one more beat of the token before
+//   song                     entries follow, played in order and over again:
+//     intro                    pattern name, then optionally
+//     verse x2 +2              `xN` plays it N times in a row, `+K` / `-K` moves it by K note indices
+// exits with 1 when the song can not be packed
+
+#include "SongPacker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // notes table of text songs, every logic other than FlashMemoryMelody picks from all of it
+    const char* const NOTE_NAMES[] = {
+            "C6", "D6", "E6", "F6", "G6", "A6", "B6",
+            "C7", "D7", "E7", "F7", "G7", "A7", "B7",
+    };
+
+    const size_t NOTE_NAMES_COUNT = sizeof(NOTE_NAMES) / sizeof(NOTE_NAMES[0]);
+
+    const char* const DEFAULT_NAME = "SampleSong";
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13SongPack <song> <header> [--name NAME]\n");
+    }
+
+    bool noteIndex(const std::string& token, uint8_t& index) {
+        for (size_t i = 0; i < NOTE_NAMES_COUNT; i++) {
+            if (token == NOTE_NAMES[i]) {
+                index = static_cast<uint8_t>(i + 1u);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool findPattern(const SongSource& source, const std::string& name, size_t& index) {
+        for (size_t i = 0; i < source.patterns.size(); i++) {
+            if (source.patterns[i].name == name) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // song entries name patterns defined anywhere in the file, they are resolved at the end
+    struct EntryLine {
+        std::string pattern;
+
+        SongSource::Entry entry;
+
+        uint32_t line;
+    };
+
+    bool parseEntry(std::istringstream& tokens, const std::string& name, EntryLine& result, std::string& error) {
+        result.pattern = name;
+        result.entry = SongSource::Entry { 0, 1, 0 };
+        std::string token;
+        while (tokens >> token) {
+            char* end = nullptr;
+            if ('x' == token[0]) {
+                const long plays = strtol(token.c_str() + 1, &end, 10);
+                if (*end != '\0' || plays < 1) {
+                    error = "bad play count '" + token + "'";
+                    return false;
+                }
+                result.entry.plays = static_cast<uint32_t>(plays);
+            } else if ('+' == token[0] || '-' == token[0]) {
+                const long transpose = strtol(token.c_str(), &end, 10);
+                if (*end != '\0' || 1 == token.size()) {
+                    error = "bad transpose '" + token + "'";
+                    return false;
+                }
+                result.entry.transpose = static_cast<int32_t>(transpose);
+            } else {
+                error = "unexpected '" + token + "'";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parse(const char* path, SongSource& source, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "can not read '" + std::string(path) + "'";
+            return false;
+        }
+        enum Section { None, Pattern, Song } section = None;
+        std::vector<EntryLine> entries;
+        std::string text;
+        for (uint32_t line = 1; std::getline(file, text); line++) {
+            text = text.substr(0, text.find('#'));
+            std::istringstream tokens(text);
+            std::string token;
+            if (!(tokens >> token)) {
+                continue;
+            }
+            const std::string where = "line " + std::to_string(line) + ": ";
+            if ("pattern" == token) {
+                std::string name;
+                size_t existing = 0;
+                if (!(tokens >> name) || (tokens >> token)) {
+                    error = where + "pattern takes one name";
+                    return false;
+                }
+                if (findPattern(source, name, existing)) {
+                    error = where + "pattern '" + name + "' is defined twice";
+                    return false;
+                }
+                source.patterns.push_back(SongSource::Pattern { name, {} });
+                section = Pattern;
+                continue;
+            }
+            if ("noise" == token && None == section) {
+                std::string name;
+                if (!(tokens >> name) || (tokens >> token) || !noteIndex(name, source.lastNoiseNote)) {
+                    error = where + "noise takes one note";
+                    return false;
+                }
+                continue;
+            }
+            if ("song" == token) {
+                if (tokens >> token) {
+                    error = where + "song takes no arguments";
+                    return false;
+                }
+                section = Song;
+                continue;
+            }
+            if (Song == section) {
+                EntryLine entry;
+                if (!parseEntry(tokens, token, entry, error)) {
+                    error = where + error;
+                    return false;
+                }
+                entry.line = line;
+                entries.push_back(entry);
+                continue;
+            }
+            if (Pattern != section) {
+                error = where + "beats outside of a pattern";
+                return false;
+            }
+            std::vector<uint8_t>& beats = source.patterns.back().beats;
+            do {
+                uint8_t beat = 0;
+                if ("." == token) {
+                    if (beats.empty()) {
+                        error = where + "'.' needs a beat before it";
+                        return false;
+                    }
+                    beat = beats.back();
+                } else if ("-" != token && !noteIndex(token, beat)) {
+                    error = where + "unknown note '" + token + "'";
+                    return false;
+                }
+                beats.push_back(beat);
+            } while (tokens >> token);
+        }
+        for (const EntryLine& line : entries) {
+            SongSource::Entry entry = line.entry;
+            if (!findPattern(source, line.pattern, entry.pattern)) {
+                error = "line " + std::to_string(line.line) + ": no pattern '" + line.pattern + "'";
+                return false;
+            }
+            source.entries.push_back(entry);
+        }
+        return true;
+    }
+
+    std::string baseName(const std::string& path) {
+        const size_t slash = path.find_last_of('/');
+        return std::string::npos == slash ? path : path.substr(slash + 1u);
+    }
+}
+
+int main(const int argc, char** argv) {
+    const char* songPath = nullptr;
+    const char* headerPath = nullptr;
+    const char* name = DEFAULT_NAME;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--name") && i + 1 < argc) {
+            name = argv[++i];
+        } else if ('-' != argv[i][0] && nullptr == songPath) {
+            songPath = argv[i];
+        } else if ('-' != argv[i][0] && nullptr == headerPath) {
+            headerPath = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (nullptr == headerPath) {
+        usage();
+        return 2;
+    }
+
+    SongSource source;
+    for (const char* const noteName : NOTE_NAMES) {
+        uint8_t note = 0;
+        parseNoteName(noteName, note);
+        source.notes.push_back(note);
+    }
+    PackedSong packed;
+    std::string error;
+    if (!parse(songPath, source, error) || !packSong(source, packed, error)) {
+        fprintf(stderr, "%s: %s\n", songPath, error.c_str());
+        return 1;
+    }
+    if (unpackSong(packed) != packed.passBeats) {
+        fprintf(stderr, "%s: packed song does not play back\n", songPath);
+        return 1;
+    }
+    if (!writeSongHeader(packed, name, "ATTiny13SongPack", baseName(songPath), headerPath)) {
+        fprintf(stderr, "can not write '%s'\n", headerPath);
+        return 2;
+    }
+
+    printf("patterns          %zu defined, %zu played, %zu kept\n",
+           source.patterns.size(), packed.playedPatterns, packed.patternNames.size());
+    printf("entries           %zu in the song, %zu packed\n", source.entries.size(), packed.entries.size());
+    printf("beats per pass    %zu\n", packed.passBeats.size());
+    printf("flash             %u bytes (codes %zu, pattern starts %zu, entries %zu)\n",
+           packed.flashBytes(), packed.bytes.size(),
+           packed.patternStarts.size() * (packed.hasShortPositions() ? 1u : 2u),
+           packed.entries.size() * sizeof(SongEntry));
+    printf("as one melody     %u bytes\n", packed.flatFlashBytes());
+    return 0;
+}
@@ -0,0 +1,361 @@
+#include "SongPacker.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    const uint32_t MAX_PLAYS = 0xFFu;
+
+    const size_t MAX_PATTERNS = 0xFFu;
+
+    const size_t MAX_ENTRIES = 0xFFu;
+
+    // a note and one repeat are as short written out, runs from 3 beats on are worth a REPEAT
+    const uint8_t MIN_RUN = 3u;
+
+    // beats in a row equal to the one at index, itself included
+    uint16_t runLength(const uint8_t* const beats, const uint16_t count, const uint16_t index) {
+        uint16_t end = index + 1u;
+        while (end < count && beats[end] == beats[index]) {
+            end++;
+        }
+        return end - index;
+    }
+
+    // codes the beats pack into
+    uint16_t packedCodes(const uint8_t* const beats, const uint16_t count) {
+        using namespace MelodyStreamDetails;
+        uint16_t codes = 0;
+        uint16_t index = 0;
+        while (index < count) {
+            uint16_t run = runLength(beats, count, index);
+            index += run;
+            // first beat of a run always takes its own code, a repeat needs something to repeat
+            codes++;
+            run--;
+            while (0 != run) {
+                const uint16_t chunk = run < MAX_RUN - 1u ? run : MAX_RUN - 1u;
+                codes += chunk < MIN_RUN - 1u ? chunk : 2u;
+                run -= chunk;
+            }
+        }
+        return codes;
+    }
+
+    // packs beats into codes from firstCode on, bytes have to start zeroed, returns the code after the last one
+    uint16_t packBeats(const uint8_t* const beats, const uint16_t count, uint8_t* const bytes,
+                       const uint16_t firstCode) {
+        using namespace MelodyStreamDetails;
+        uint16_t code = firstCode;
+        uint16_t index = 0;
+        while (index < count) {
+            const uint8_t beat = beats[index];
+            uint16_t run = runLength(beats, count, index);
+            index += run;
+            uint8_t values[2] = { beat, 0 };
+            uint8_t valuesCount = 1;
+            run--;
+            do {
+                for (uint8_t i = 0; i < valuesCount; i++, code++) {
+                    bytes[code / 2u] |= 0 == code % 2u ? static_cast<uint8_t>(values[i] << 4u) : values[i];
+                }
+                const uint16_t chunk = run < MAX_RUN - 1u ? run : MAX_RUN - 1u;
+                if (chunk < MIN_RUN - 1u) {
+                    // the beat itself again, values may hold a REPEAT from the chunk before
+                    values[0] = beat;
+                    values[1] = beat;
+                    valuesCount = static_cast<uint8_t>(chunk);
+                } else {
+                    values[0] = REPEAT;
+                    values[1] = static_cast<uint8_t>(chunk - 1u);
+                    valuesCount = 2;
+                }
+                run -= chunk;
+            } while (0 != valuesCount);
+        }
+        return code;
+    }
+
+    bool isNoise(const int32_t note, const uint8_t lastNoiseNote) {
+        return note <= static_cast<int32_t>(lastNoiseNote);
+    }
+
+    // pattern is the kept one moved by offset, with drums in the same beats
+    bool isTransposed(const std::vector<uint8_t>& pattern, const std::vector<uint8_t>& kept,
+                      const uint8_t lastNoiseNote, int32_t& offset) {
+        if (pattern.size() != kept.size()) {
+            return false;
+        }
+        bool hasOffset = false;
+        for (size_t i = 0; i < pattern.size(); i++) {
+            if ((0 == pattern[i]) != (0 == kept[i])
+                || isNoise(pattern[i], lastNoiseNote) != isNoise(kept[i], lastNoiseNote)) {
+                return false;
+            }
+            if (0 == pattern[i]) {
+                continue;
+            }
+            const int32_t difference = static_cast<int32_t>(pattern[i]) - static_cast<int32_t>(kept[i]);
+            if (hasOffset && difference != offset) {
+                return false;
+            }
+            offset = difference;
+            hasOffset = true;
+        }
+        if (!hasOffset) {
+            offset = 0;
+        }
+        return true;
+    }
+
+    void printBytes(FILE* file, const std::vector<uint8_t>& bytes) {
+        for (size_t i = 0; i < bytes.size(); i++) {
+            fprintf(file, "%s0x%02X,%s", 0 == i % 12u ? "            " : " ", bytes[i],
+                    11u == i % 12u || bytes.size() == i + 1u ? "\n" : "");
+        }
+    }
+}
+
+uint32_t noteFrequency(const uint8_t midiNote) {
+    return static_cast<uint32_t>(lround(44000.0 * pow(2.0, (midiNote - 69.0) / 12.0)));
+}
+
+std::string noteName(const uint8_t midiNote) {
+    static const char* const NAMES[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    return NAMES[midiNote % 12u] + std::to_string(midiNote / 12 - 1);
+}
+
+bool parseNoteName(const std::string& name, uint8_t& midiNote) {
+    for (uint8_t note = 12u; note < 128u; note++) {
+        if (noteName(note) == name) {
+            midiNote = note;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t PackedSong::flashBytes() const {
+    return static_cast<uint32_t>(bytes.size()
+            + patternStarts.size() * (hasShortPositions() ? 1u : 2u)
+            + entries.size() * sizeof(SongEntry));
+}
+
+bool packSong(const SongSource& source, PackedSong& packed, std::string& error) {
+    packed = PackedSong();
+    if (source.notes.empty() || source.notes.size() > SONG_MAX_NOTE) {
+        error = "notes table takes 1.." + std::to_string(SONG_MAX_NOTE) + " notes";
+        return false;
+    }
+    packed.notes = source.notes;
+    const int32_t highestNote = static_cast<int32_t>(source.notes.size());
+    if (source.lastNoiseNote > highestNote) {
+        error = "drums go past the notes table";
+        return false;
+    }
+    packed.lastNoiseNote = source.lastNoiseNote;
+    if (source.entries.empty()) {
+        error = "song plays no pattern";
+        return false;
+    }
+
+    // source pattern -> kept pattern and offset, in the order patterns are first played
+    std::vector<int32_t> keptIndex(source.patterns.size(), -1);
+    std::vector<int32_t> keptOffset(source.patterns.size(), 0);
+    std::vector<const std::vector<uint8_t>*> kept;
+    for (const SongSource::Entry& entry : source.entries) {
+        if (entry.pattern >= source.patterns.size()) {
+            error = "song plays an undefined pattern";
+            return false;
+        }
+        if (keptIndex[entry.pattern] >= 0) {
+            continue;
+        }
+        const SongSource::Pattern& pattern = source.patterns[entry.pattern];
+        if (pattern.beats.empty()) {
+            error = "pattern '" + pattern.name + "' has no beats";
+            return false;
+        }
+        packed.playedPatterns++;
+        for (size_t k = 0; k < kept.size() && keptIndex[entry.pattern] < 0; k++) {
+            int32_t offset = 0;
+            if (isTransposed(pattern.beats, *kept[k], source.lastNoiseNote, offset)) {
+                keptIndex[entry.pattern] = static_cast<int32_t>(k);
+                keptOffset[entry.pattern] = offset;
+            }
+        }
+        if (keptIndex[entry.pattern] < 0) {
+            keptIndex[entry.pattern] = static_cast<int32_t>(kept.size());
+            kept.push_back(&pattern.beats);
+            packed.patternNames.push_back(pattern.name);
+        }
+    }
+    if (kept.size() > MAX_PATTERNS) {
+        error = "more than 255 different patterns";
+        return false;
+    }
+
+    std::vector<uint8_t> flat;
+    for (const SongSource::Entry& entry : source.entries) {
+        const uint8_t pattern = static_cast<uint8_t>(keptIndex[entry.pattern]);
+        const int32_t transpose = entry.transpose + keptOffset[entry.pattern];
+        for (const uint8_t beat : *kept[pattern]) {
+            const int32_t note = static_cast<int32_t>(beat) + transpose;
+            if (0 != beat && (note < 1 || note > highestNote)) {
+                error = "pattern '" + source.patterns[entry.pattern].name + "' transposed by "
+                        + std::to_string(entry.transpose) + " leaves the notes table";
+                return false;
+            }
+            if (0 != beat && isNoise(note, source.lastNoiseNote) != isNoise(beat, source.lastNoiseNote)) {
+                error = "pattern '" + source.patterns[entry.pattern].name + "' transposed by "
+                        + std::to_string(entry.transpose) + " moves notes between drums and the rest";
+                return false;
+            }
+        }
+        for (uint32_t play = 0; play < entry.plays; play++) {
+            for (const uint8_t beat : *kept[pattern]) {
+                flat.push_back(0 == beat ? 0 : static_cast<uint8_t>(beat + transpose));
+            }
+        }
+        uint32_t plays = entry.plays;
+        if (!packed.entries.empty()) {
+            SongEntry& last = packed.entries.back();
+            if (last.pattern == pattern && last.transpose == transpose && last.plays < MAX_PLAYS) {
+                const uint32_t added = plays < MAX_PLAYS - last.plays ? plays : MAX_PLAYS - last.plays;
+                last.plays = static_cast<uint8_t>(last.plays + added);
+                plays -= added;
+            }
+        }
+        while (0 != plays) {
+            const uint32_t chunk = plays < MAX_PLAYS ? plays : MAX_PLAYS;
+            packed.entries.push_back(SongEntry {
+                    pattern, static_cast<uint8_t>(chunk), static_cast<int8_t>(transpose) });
+            plays -= chunk;
+        }
+    }
+    if (packed.entries.size() > MAX_ENTRIES) {
+        error = "more than 255 song entries";
+        return false;
+    }
+    if (flat.empty()) {
+        error = "song plays no beats";
+        return false;
+    }
+    packed.passBeats = flat;
+    // a single melody holds at most 64K beats, longer passes are counted as melodies of that many
+    for (size_t first = 0; first < flat.size(); first += 0xFFFFu) {
+        const size_t count = flat.size() - first < 0xFFFFu ? flat.size() - first : 0xFFFFu;
+        packed.flatCodes += packedCodes(flat.data() + first, static_cast<uint16_t>(count));
+    }
+
+    uint32_t codes = 0;
+    for (const std::vector<uint8_t>* const pattern : kept) {
+        codes += packedCodes(pattern->data(), static_cast<uint16_t>(pattern->size()));
+    }
+    if (codes > 0xFFFFu) {
+        error = "patterns do not fit 64K codes";
+        return false;
+    }
+    packed.codes = static_cast<uint16_t>(codes);
+    packed.bytes.assign((codes + 1u) / 2u, 0);
+    uint16_t code = 0;
+    for (const std::vector<uint8_t>* const pattern : kept) {
+        packed.patternStarts.push_back(code);
+        code = packBeats(pattern->data(), static_cast<uint16_t>(pattern->size()), packed.bytes.data(), code);
+    }
+    packed.patternStarts.push_back(code);
+    return true;
+}
+
+std::vector<uint8_t> unpackSong(const PackedSong& packed) {
+    std::vector<uint8_t> beats;
+    for (const SongEntry& entry : packed.entries) {
+        for (uint8_t play = 0; play < entry.plays; play++) {
+            uint8_t lastBeat = 0;
+            for (uint16_t code = packed.patternStarts[entry.pattern];
+                 code < packed.patternStarts[entry.pattern + 1u]; code++) {
+                const uint8_t byte = packed.bytes[code / 2u];
+                const uint8_t value = 0 == code % 2u ? byte >> 4u : byte & 0x0Fu;
+                if (MelodyStreamDetails::REPEAT == value) {
+                    code++;
+                    const uint8_t repeats = packed.bytes[code / 2u];
+                    beats.insert(beats.end(), (0 == code % 2u ? repeats >> 4u : repeats & 0x0Fu) + 1u, lastBeat);
+                } else {
+                    lastBeat = 0 == value ? 0 : static_cast<uint8_t>(value + entry.transpose);
+                    beats.push_back(lastBeat);
+                }
+            }
+        }
+    }
+    return beats;
+}
+
+bool writeSongHeader(const PackedSong& packed, const std::string& name, const std::string& toolName,
+                     const std::string& sourceName, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (nullptr == file) {
+        return false;
+    }
+    // SampleSong -> APP_SAMPLE_SONG_H
+    std::string guard = "APP";
+    for (size_t i = 0; i < name.size(); i++) {
+        const char c = name[i];
+        if (0 == i || (c >= 'A' && c <= 'Z')) {
+            guard += '_';
+        }
+        guard += static_cast<char>(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+    }
+    guard += "_H";
+    const char* const positionType = packed.hasShortPositions() ? "uint8_t" : "uint16_t";
+
+    fprintf(file, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+    fprintf(file, "// generated by %s from %s, do not edit\n", toolName.c_str(), sourceName.c_str());
+    fprintf(file, "// %zu patterns played, %zu kept, %zu entries, %zu beats per pass\n",
+            packed.playedPatterns, packed.patternNames.size(), packed.entries.size(), packed.passBeats.size());
+    fprintf(file, "// %u bytes of flash, %u written out as one melody\n\n",
+            packed.flashBytes(), packed.flatFlashBytes());
+    // may be written anywhere, so MelodyStream.h (SongEntry) is left to the includer
+    fprintf(file, "// m-toolbox/MelodyStream.h has to be included before\n\n");
+    fprintf(file, "#include <stdint.h>\n\n#include <avr/pgmspace.h>\n\n");
+    fprintf(file, "namespace %s {\n", name.c_str());
+    fprintf(file, "    // 1/100 Hz, note indices the song plays, each waveform engine derives its timer settings from these\n");
+    fprintf(file, "    constexpr uint32_t NOTES_FREQUENCIES[] = {\n");
+    for (uint8_t index = 0; index < SONG_NOTES_TABLE_SIZE; index++) {
+        // past the song's notes the table starts over, index 0 is the one after the last
+        const bool isRepeat = 0 == index || index > packed.notes.size();
+        const uint8_t note = packed.notes.empty() ? SONG_FILLER_NOTE
+                : packed.notes[(index + SONG_NOTES_TABLE_SIZE - 1u) % SONG_NOTES_TABLE_SIZE % packed.notes.size()];
+        const int written = fprintf(file, "            %u,", noteFrequency(note));
+        fprintf(file, "%*s// %s%s\n", 24 - written, "", noteName(note).c_str(),
+                packed.notes.empty() ? ", filler" : isRepeat ? ", repeat" : (index <= packed.lastNoiseNote ? ", drum" : ""));
+    }
+    fprintf(file, "    };\n\n");
+    fprintf(file, "    const uint8_t CODES[] PROGMEM = {\n");
+    printBytes(file, packed.bytes);
+    fprintf(file, "    };\n\n");
+    fprintf(file, "    const %s PATTERN_STARTS[] PROGMEM = {\n", positionType);
+    for (size_t i = 0; i < packed.patternStarts.size(); i++) {
+        fprintf(file, "            %u,", packed.patternStarts[i]);
+        fprintf(file, i < packed.patternNames.size() ? "%*s// %s\n" : "\n",
+                static_cast<int>(8 - std::to_string(packed.patternStarts[i]).size()), "",
+                i < packed.patternNames.size() ? packed.patternNames[i].c_str() : "");
+    }
+    fprintf(file, "    };\n\n");
+    fprintf(file, "    const SongEntry ENTRIES[] PROGMEM = {\n");
+    for (const SongEntry& entry : packed.entries) {
+        const int written = fprintf(file, "            { %u, %u, %d },", entry.pattern, entry.plays, entry.transpose);
+        fprintf(file, "%*s// %s\n", 32 - written, "", packed.patternNames[entry.pattern].c_str());
+    }
+    fprintf(file, "    };\n\n");
+    fprintf(file, "    struct Song {\n");
+    fprintf(file, "        typedef %s Position;\n\n", positionType);
+    fprintf(file, "        static const uint8_t ENTRIES_COUNT = %zu;\n\n", packed.entries.size());
+    fprintf(file, "        // note indices up to this one are drums, FlashMemoryMelody plays them as noise, 0 for none\n");
+    fprintf(file, "        static const uint8_t LAST_NOISE_NOTE = %u;\n\n", packed.lastNoiseNote);
+    fprintf(file, "        static const uint8_t* codes() {\n            return CODES;\n        }\n\n");
+    fprintf(file, "        static const Position* patternStarts() {\n            return PATTERN_STARTS;\n        }\n\n");
+    fprintf(file, "        static const SongEntry* entries() {\n            return ENTRIES;\n        }\n");
+    fprintf(file, "    };\n}\n\n#endif // %s\n", guard.c_str());
+    return 0 == fclose(file);
+}
@@ -0,0 +1,115 @@
+#ifndef HOST_SONG_PACKER_H
+#define HOST_SONG_PACKER_H
+
+// song arrangement for SongStream (src/m-toolbox/MelodyStream.h): patterns of beats and the entries
+// playing them, folded and packed into the flash layout a generated header hands to the firmware
+//
+// a pattern equal to an earlier one, or to an earlier one moved by a constant number of note indices
+// (rests in the same beats), is dropped and its entries play the earlier one transposed;
+// neighbour entries playing the same pattern with the same transpose become one
+// the header also carries the notes table the firmware plays, index 0 and unused indices repeat the song's notes
+// (as if the index wrapped at the last one, so logics stepping through the table stay on them),
+// and the last drum note: FlashMemoryMelody plays the notes up to it as noise, transposes keep drums drums
+
+#include <MelodyStream.h>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct SongSource {
+    // midi note of every note index from 1 on
+    std::vector<uint8_t> notes;
+
+    // note indices 1..lastNoiseNote are drums, 0 for none
+    uint8_t lastNoiseNote = 0;
+
+    struct Pattern {
+        std::string name;
+
+        // note indices, 0 is a rest
+        std::vector<uint8_t> beats;
+    };
+
+    struct Entry {
+        size_t pattern;
+
+        uint32_t plays;
+
+        int32_t transpose;
+    };
+
+    std::vector<Pattern> patterns;
+
+    std::vector<Entry> entries;
+};
+
+struct PackedSong {
+    std::vector<uint8_t> notes;
+
+    uint8_t lastNoiseNote = 0;
+
+    std::vector<uint8_t> bytes;
+
+    uint16_t codes = 0;
+
+    // first code of every kept pattern, then the codes count
+    std::vector<uint16_t> patternStarts;
+
+    std::vector<SongEntry> entries;
+
+    // name of every kept pattern
+    std::vector<std::string> patternNames;
+
+    // patterns the source defines and plays
+    size_t playedPatterns = 0;
+
+    // one pass of the song as the source plays it
+    std::vector<uint8_t> passBeats;
+
+    // codes of one pass written out as a single melody
+    uint32_t flatCodes = 0;
+
+    bool hasShortPositions() const {
+        return codes <= 0xFFu;
+    }
+
+    uint32_t flashBytes() const;
+
+    // one pass written out as a single melody
+    uint32_t flatFlashBytes() const {
+        return (flatCodes + 1u) / 2u;
+    }
+};
+
+// highest note index a song may play, REPEAT is taken
+const uint8_t SONG_MAX_NOTE = MelodyStreamDetails::REPEAT - 1u;
+
+// entries of the notes table, a power of 2 keeps the index wrap of the engines cheap
+const uint8_t SONG_NOTES_TABLE_SIZE = 16u;
+
+// C2, the whole table of a song without notes; a lower note outlasts the shortest subdivision in one CTC wave period
+const uint8_t SONG_FILLER_NOTE = 36u;
+
+// 1/100 Hz, equal temperament with A4 at 440 Hz
+uint32_t noteFrequency(uint8_t midiNote);
+
+// "C#6"
+std::string noteName(uint8_t midiNote);
+
+bool parseNoteName(const std::string& name, uint8_t& midiNote);
+
+// fails on empty patterns or songs, notes out of 1..notes count after transposing, a transpose moving
+// a note between drums and the rest,
+// more than SONG_MAX_NOTE notes, more than 255 kept patterns or entries
+bool packSong(const SongSource& source, PackedSong& packed, std::string& error);
+
+// all the beats of one pass, as SongStream plays them, equal to passBeats
+std::vector<uint8_t> unpackSong(const PackedSong& packed);
+
+// header with `namespace <name>` holding the notes table, the data and its Song struct
+bool writeSongHeader(const PackedSong& packed, const std::string& name, const std::string& toolName,
+                     const std::string& sourceName, const std::string& path);
+
+#endif // HOST_SONG_PACKER_H
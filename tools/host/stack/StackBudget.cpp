@@ -0,0 +1,416 @@
+// sram budget of the firmware image: .data and .bss plus the deepest stack,
+// that is the deepest main loop path with the deepest interrupt handler on top of it
+//
+// usage: ATTiny13StackBudget <listing> <symbols> <stack usage dir> [--indirect PART]...
+//   listing is `avr-objdump -d` output, symbols is `avr-nm -S` output,
+//   stack usage dir is searched for the .su files `-fstack-usage` leaves next to the objects
+//   indirect calls and jumps may go to every function with PART in its (mangled) name
+//
+// frames come from .su files (they include the return address), the call graph from calls
+// and tail jumps in the listing; functions without .su (libgcc, crt) are estimated as
+// return address + their pushes
+// exits with 1 when it does not fit the sram or the stack can not be bounded
+
+#include "../isr/AvrListing.h"
+
+#include <cxxabi.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    // attiny13a, RAMSTART 0x60 .. RAMEND 0x9f
+    const uint32_t SRAM_SIZE = 64;
+
+    // avr-nm shows sram addresses with this offset
+    const uint32_t SRAM_NM_OFFSET = 0x800000;
+
+    const uint32_t RETURN_ADDRESS_BYTES = 2;
+
+    struct RamSymbol {
+        std::string name;
+
+        uint32_t size;
+
+        bool isData;
+    };
+
+    struct Frame {
+        uint32_t bytes;
+
+        // no .su entry, estimated from pushes
+        bool isEstimated;
+    };
+
+    struct Depth {
+        uint32_t bytes;
+
+        // deepest callee, 0 when none
+        uint32_t next;
+    };
+
+    void usage() {
+        fprintf(stderr, "usage: ATTiny13StackBudget <listing> <symbols> <stack usage dir> [--indirect PART]...\n");
+    }
+
+    std::string demangle(const std::string& symbol) {
+        int status = 0;
+        char* const demangled = abi::__cxa_demangle(symbol.c_str(), nullptr, nullptr, &status);
+        if (nullptr == demangled) {
+            return symbol;
+        }
+        const std::string result = demangled;
+        free(demangled);
+        return result;
+    }
+
+    // .su declarations and demangled symbols spell the same function differently:
+    //   "void WaveformGen::{anonymous}::fetchNextNote()"
+    //   "WaveformGen::(anonymous namespace)::fetchNextNote() [clone .constprop.0]"
+    // both come down to the qualified name without return type and parameters
+    std::string normalize(std::string name) {
+        static const std::string ANONYMOUS = "(anonymous namespace)";
+        for (size_t at = name.find(ANONYMOUS); std::string::npos != at; at = name.find(ANONYMOUS)) {
+            name.replace(at, ANONYMOUS.size(), "{anonymous}");
+        }
+        int templateDepth = 0;
+        size_t nameStart = 0;
+        size_t nameEnd = name.size();
+        for (size_t i = 0; i < name.size() && nameEnd == name.size(); i++) {
+            const char c = name[i];
+            if ('<' == c) {
+                templateDepth++;
+            } else if ('>' == c) {
+                templateDepth--;
+            } else if (0 == templateDepth && ' ' == c) {
+                nameStart = i + 1;
+            } else if (0 == templateDepth && '(' == c) {
+                nameEnd = i;
+            }
+        }
+        return name.substr(nameStart, nameEnd - nameStart);
+    }
+
+    bool loadRamSymbols(const char* path, std::vector<RamSymbol>& result) {
+        std::ifstream input(path);
+        if (!input) {
+            return false;
+        }
+        // "00800062 00000009 b _ZN11WaveformGen12_GLOBAL__N_13wgsE"
+        static const std::regex SYMBOL("^([0-9a-f]+) ([0-9a-f]+) ([bBdD]) (.+)$");
+        std::string line;
+        std::smatch match;
+        while (std::getline(input, line)) {
+            if (!std::regex_match(line, match, SYMBOL)) {
+                continue;
+            }
+            const uint32_t address = static_cast<uint32_t>(strtoul(match[1].str().c_str(), nullptr, 16));
+            if (address < SRAM_NM_OFFSET) {
+                continue;
+            }
+            const char type = match[3].str()[0];
+            result.push_back(RamSymbol {
+                demangle(match[4]),
+                static_cast<uint32_t>(strtoul(match[2].str().c_str(), nullptr, 16)),
+                'd' == type || 'D' == type,
+            });
+        }
+        return true;
+    }
+
+    // static and "dynamic,bounded" frames, "dynamic" ones go to unbounded
+    void loadStackUsageFile(const std::string& path, std::map<std::string, uint32_t>& frames,
+                            std::vector<std::string>& unbounded) {
+        std::ifstream input(path);
+        // "main.cpp:1288:5:int main()\t2\tstatic"
+        static const std::regex ENTRY("^[^:]*:[0-9]+:[0-9]+:(.*)\t([0-9]+)\t(.*)$");
+        std::string line;
+        std::smatch match;
+        while (std::getline(input, line)) {
+            if (!std::regex_match(line, match, ENTRY)) {
+                continue;
+            }
+            const std::string name = normalize(match[1]);
+            if ("dynamic" == match[3].str()) {
+                unbounded.push_back(name);
+                continue;
+            }
+            const uint32_t bytes = static_cast<uint32_t>(strtoul(match[2].str().c_str(), nullptr, 10));
+            uint32_t& frame = frames[name];
+            frame = bytes > frame ? bytes : frame;
+        }
+    }
+
+    void loadStackUsage(const std::string& dir, std::map<std::string, uint32_t>& frames,
+                        std::vector<std::string>& unbounded) {
+        DIR* const handle = opendir(dir.c_str());
+        if (nullptr == handle) {
+            return;
+        }
+        while (const dirent* const entry = readdir(handle)) {
+            const std::string name = entry->d_name;
+            if ("." == name || ".." == name) {
+                continue;
+            }
+            const std::string path = dir + "/" + name;
+            if (name.size() > 3 && 0 == name.compare(name.size() - 3, 3, ".su")) {
+                loadStackUsageFile(path, frames, unbounded);
+            } else if (DT_DIR == entry->d_type) {
+                loadStackUsage(path, frames, unbounded);
+            }
+        }
+        closedir(handle);
+    }
+
+    class StackDepth {
+    public:
+        StackDepth(const AvrListing& listing, const std::map<std::string, uint32_t>& frames)
+                : listing(listing), frames(frames) {
+        }
+
+        // deepest stack of a function and everything it calls, false if it can not be bounded
+        bool depth(const uint32_t function, Depth& result) {
+            const auto known = depths.find(function);
+            if (known != depths.end()) {
+                result = known->second;
+                return true;
+            }
+            if (!active.insert(function).second) {
+                return fail("recursion through " + listing.describe(function));
+            }
+            const Frame own = frame(function);
+            Depth deepest { own.bytes, 0 };
+            for (const AvrInstruction* const instruction : body(function)) {
+                const std::string& m = instruction->mnemonic;
+                const bool isIndirect = "icall" == m || "ijmp" == m;
+                if (isIndirect && indirectTargets.empty()) {
+                    return fail("indirect call or jump at " + listing.describe(instruction->address));
+                }
+                const bool isCall = "rcall" == m || "call" == m || "icall" == m;
+                const bool isJump = "rjmp" == m || "jmp" == m || "ijmp" == m;
+                if (!isIndirect && (!(isCall || isJump) || !instruction->hasTarget)) {
+                    continue;
+                }
+                const std::vector<uint32_t> callees = isIndirect
+                        ? indirectTargets
+                        : std::vector<uint32_t> { functionAt(instruction->target) };
+                for (const uint32_t callee : callees) {
+                    // jumps inside the function are not calls, jumps out of it are tail calls
+                    if (isJump && callee == function) {
+                        continue;
+                    }
+                    Depth inner { 0, 0 };
+                    if (!depth(callee, inner)) {
+                        return false;
+                    }
+                    // a tail call reuses the frame of the caller, its return address included
+                    const uint32_t bytes = isCall ? own.bytes + inner.bytes : inner.bytes;
+                    if (bytes > deepest.bytes) {
+                        deepest = Depth { bytes, callee };
+                    }
+                }
+            }
+            active.erase(function);
+            depths[function] = deepest;
+            result = deepest;
+            return true;
+        }
+
+        Frame frame(const uint32_t function) const {
+            const std::string name = normalize(demangle(listing.symbols().at(function)));
+            const auto su = frames.find(name);
+            if (su != frames.end()) {
+                return Frame { su->second, false };
+            }
+            uint32_t pushes = 0;
+            for (const AvrInstruction* const instruction : body(function)) {
+                pushes += "push" == instruction->mnemonic ? 1u : 0u;
+            }
+            return Frame { RETURN_ADDRESS_BYTES + pushes, true };
+        }
+
+        bool enablesInterrupts(const uint32_t function) const {
+            for (const AvrInstruction* const instruction : body(function)) {
+                if ("sei" == instruction->mnemonic) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const std::string& error() const {
+            return errorMessage;
+        }
+
+        // icall and ijmp may go to any of these functions
+        void setIndirectTargets(const std::vector<uint32_t>& targets) {
+            indirectTargets = targets;
+        }
+
+    private:
+        const AvrListing& listing;
+
+        const std::map<std::string, uint32_t>& frames;
+
+        std::map<uint32_t, Depth> depths;
+
+        std::set<uint32_t> active;
+
+        std::vector<uint32_t> indirectTargets;
+
+        std::string errorMessage;
+
+        bool fail(const std::string& message) {
+            if (errorMessage.empty()) {
+                errorMessage = message;
+            }
+            return false;
+        }
+
+        // start of the symbol the address belongs to
+        uint32_t functionAt(const uint32_t address) const {
+            auto it = listing.symbols().upper_bound(address);
+            return it == listing.symbols().begin() ? address : (--it)->first;
+        }
+
+        std::vector<const AvrInstruction*> body(const uint32_t function) const {
+            const auto next = listing.symbols().upper_bound(function);
+            return listing.range(function, next == listing.symbols().end() ? UINT32_MAX : next->first);
+        }
+    };
+
+    // "main 6 > Fooz::Logic... 4 > __udivmodsi4 2"
+    std::string describePath(const AvrListing& listing, StackDepth& stack, uint32_t function) {
+        std::string result;
+        while (true) {
+            const Frame own = stack.frame(function);
+            result += demangle(listing.symbols().at(function)) + " " + (own.isEstimated ? "~" : "")
+                    + std::to_string(own.bytes);
+            Depth depth { 0, 0 };
+            if (!stack.depth(function, depth) || 0 == depth.next) {
+                return result;
+            }
+            result += " > ";
+            function = depth.next;
+        }
+    }
+}
+
+int main(const int argc, char** argv) {
+    std::vector<const char*> paths;
+    std::vector<std::string> indirectParts;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--indirect") && i + 1 < argc) {
+            indirectParts.push_back(argv[++i]);
+        } else if ('-' != argv[i][0]) {
+            paths.push_back(argv[i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (3 != paths.size()) {
+        usage();
+        return 2;
+    }
+
+    AvrListing listing;
+    if (!listing.load(paths[0])) {
+        fprintf(stderr, "no instructions in '%s'\n", paths[0]);
+        return 2;
+    }
+    std::vector<RamSymbol> ramSymbols;
+    if (!loadRamSymbols(paths[1], ramSymbols)) {
+        fprintf(stderr, "can not read symbols '%s'\n", paths[1]);
+        return 2;
+    }
+    std::map<std::string, uint32_t> frames;
+    std::vector<std::string> unboundedFrames;
+    loadStackUsage(paths[2], frames, unboundedFrames);
+    if (frames.empty()) {
+        fprintf(stderr, "no .su files in '%s', build with -fstack-usage\n", paths[2]);
+        return 2;
+    }
+
+    uint32_t dataBytes = 0;
+    uint32_t bssBytes = 0;
+    printf("static sram\n");
+    for (const RamSymbol& symbol : ramSymbols) {
+        printf("  %-6s %3u  %s\n", symbol.isData ? ".data" : ".bss", symbol.size, symbol.name.c_str());
+        (symbol.isData ? dataBytes : bssBytes) += symbol.size;
+    }
+
+    StackDepth stack(listing, frames);
+    std::vector<uint32_t> indirectTargets;
+    for (const std::string& part : indirectParts) {
+        const std::vector<uint32_t> targets = listing.symbolsContaining(part);
+        indirectTargets.insert(indirectTargets.end(), targets.begin(), targets.end());
+    }
+    stack.setIndirectTargets(indirectTargets);
+    bool isBounded = unboundedFrames.empty();
+    for (const std::string& name : unboundedFrames) {
+        printf("unbounded: dynamic stack frame in %s\n", name.c_str());
+    }
+
+    printf("stack, bytes per frame along the deepest path (~ estimated from pushes)\n");
+    uint32_t mainBytes = 0;
+    uint32_t mainAddress = 0;
+    if (!listing.symbolAddress("main", mainAddress)) {
+        printf("unbounded: no main in the listing\n");
+        isBounded = false;
+    } else {
+        Depth depth { 0, 0 };
+        if (stack.depth(mainAddress, depth)) {
+            mainBytes = depth.bytes;
+            printf("  %-12s %3u  %s\n", "main", depth.bytes, describePath(listing, stack, mainAddress).c_str());
+        } else {
+            printf("  %-12s unbounded: %s\n", "main", stack.error().c_str());
+            isBounded = false;
+        }
+    }
+
+    // handlers do not nest unless one of them enables interrupts, then they all may
+    uint32_t deepestHandler = 0;
+    uint32_t allHandlers = 0;
+    bool isNesting = false;
+    static const std::regex VECTOR("^__vector_[0-9]+$");
+    for (const auto& symbol : listing.symbols()) {
+        if (!std::regex_match(symbol.second, VECTOR)) {
+            continue;
+        }
+        Depth depth { 0, 0 };
+        if (!stack.depth(symbol.first, depth)) {
+            printf("  %-12s unbounded: %s\n", symbol.second.c_str(), stack.error().c_str());
+            isBounded = false;
+            continue;
+        }
+        printf("  %-12s %3u  %s\n", symbol.second.c_str(), depth.bytes,
+               describePath(listing, stack, symbol.first).c_str());
+        deepestHandler = depth.bytes > deepestHandler ? depth.bytes : deepestHandler;
+        allHandlers += depth.bytes;
+        isNesting = isNesting || stack.enablesInterrupts(symbol.first);
+    }
+    const uint32_t handlersBytes = isNesting ? allHandlers : deepestHandler;
+    if (isNesting) {
+        printf("a handler enables interrupts, all handlers are assumed nested\n");
+    }
+
+    if (!isBounded) {
+        printf("FAIL: stack depth can not be bounded\n");
+        return 1;
+    }
+    const uint32_t total = dataBytes + bssBytes + mainBytes + handlersBytes;
+    const bool isWithin = total <= SRAM_SIZE;
+    printf("%s: .data %u + .bss %u + main %u + interrupts %u = %u of %u bytes sram, %d free\n",
+           isWithin ? "OK" : "FAIL", dataBytes, bssBytes, mainBytes, handlersBytes, total, SRAM_SIZE,
+           static_cast<int>(SRAM_SIZE) - static_cast<int>(total));
+    return isWithin ? 0 : 1;
+}